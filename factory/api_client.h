@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <mutex>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <curl/curl.h>
+#include "api_metrics.h"
+#include "async_logger.h"
+
+// Callback function for libcurl to write the response data
+inline size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
+    ((std::string*)userp)->append((char*)contents, size * nmemb);
+    return size * nmemb;
+}
+
+// Result of a single API call. status is 0 when the request never got a response.
+struct HTTPResponse {
+    std::string body;
+    long status = 0;
+    CURLcode curlCode = CURLE_OK;
+
+    bool ok() const {
+        return curlCode == CURLE_OK && status >= 200 && status < 300;
+    }
+};
+
+// Reads curl's cumulative phase timestamps and turns them into per-phase durations
+inline ApiCallTiming readCallTiming(CURL* curl) {
+    curl_off_t nameLookup = 0, connect = 0, appConnect = 0, startTransfer = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &nameLookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appConnect);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &startTransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    ApiCallTiming timing;
+    timing.dnsMicros = nameLookup;
+    timing.connectMicros = connect > nameLookup ? connect - nameLookup : 0;
+    timing.tlsMicros = appConnect > connect ? appConnect - connect : 0;  // 0 for plain HTTP or a reused connection
+    // Time from the end of the handshake to the first response byte, so every
+    // phase in k8s_api_phase_duration_seconds is a duration rather than a timestamp
+    curl_off_t handshakeDone = std::max(connect, appConnect);
+    timing.ttfbMicros = startTransfer > handshakeDone ? startTransfer - handshakeDone : 0;
+    timing.totalMicros = total;
+    return timing;
+}
+
+// Performs one request on a caller-supplied handle. The handle is reset
+// first, but curl keeps its connection cache, so reusing a handle across
+// calls to the same server skips the TCP and TLS handshakes.
+inline HTTPResponse performHTTPRequest(CURL* curl, const std::string& url, const std::string& token, const std::string& method, const std::string& body = "") {
+    HTTPResponse response;
+    curl_easy_reset(curl);
+
+    struct curl_slist* headers = NULL;
+    headers = curl_slist_append(headers, ("Authorization: Bearer " + token).c_str());
+    headers = curl_slist_append(headers, "Content-Type: application/json");
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+
+    if (method == "POST" || method == "PUT") {
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // Only for local development
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);  // Only for local development
+
+    response.curlCode = curl_easy_perform(curl);
+    if (response.curlCode != CURLE_OK) {
+        LOG_ERROR("curl_easy_perform() failed: ", curl_easy_strerror(response.curlCode));
+    }
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    ApiMetrics::instance().recordCall(apiVerbFromMethod(method), apiKindFromURL(url), readCallTiming(curl), !response.ok());
+
+    curl_slist_free_all(headers);
+    return response;
+}
+
+// Function to make an HTTP request using libcurl
+inline HTTPResponse performHTTPRequest(const std::string& url, const std::string& token, const std::string& method, const std::string& body = "") {
+    HTTPResponse response;
+    CURL* curl = curl_easy_init();
+    if (curl) {
+        response = performHTTPRequest(curl, url, token, method, body);
+        curl_easy_cleanup(curl);
+    }
+    return response;
+}
+
+inline std::string makeHTTPRequest(const std::string& url, const std::string& token, const std::string& method, const std::string& body = "") {
+    return performHTTPRequest(url, token, method, body).body;
+}
+
+// Single-flight layer for reads: concurrent callers asking for the same key
+// share one in-flight fetch instead of each hitting the API server. With a
+// non-zero TTL, completed responses are also served from a short-lived cache.
+class RequestCoalescer {
+public:
+    struct Stats {
+        std::atomic<uint64_t> hits{0};     // Served from the TTL cache
+        std::atomic<uint64_t> misses{0};   // Went to the API server
+        std::atomic<uint64_t> joined{0};   // Waited on another caller's request
+    };
+
+    explicit RequestCoalescer(std::chrono::milliseconds ttl = std::chrono::milliseconds(0)) : ttl(ttl) {}
+
+    HTTPResponse get(const std::string& key, const std::function<HTTPResponse()>& fetch) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (ttl.count() > 0) {
+            auto cached = cache.find(key);
+            if (cached != cache.end()) {
+                if (Clock::now() < cached->second.expires) {
+                    stats.hits.fetch_add(1, std::memory_order_relaxed);
+                    return cached->second.response;
+                }
+                cache.erase(cached);
+            }
+        }
+
+        auto pending = inflight.find(key);
+        if (pending != inflight.end()) {
+            std::shared_future<HTTPResponse> result = pending->second.result;
+            lock.unlock();
+            stats.joined.fetch_add(1, std::memory_order_relaxed);
+            return result.get();
+        }
+
+        std::promise<HTTPResponse> promise;
+        uint64_t ticket = ++nextTicket;
+        inflight.emplace(key, InflightFetch{ticket, promise.get_future().share()});
+        uint64_t startGeneration = generation;
+        lock.unlock();
+        stats.misses.fetch_add(1, std::memory_order_relaxed);
+
+        HTTPResponse response;
+        try {
+            response = fetch();
+        } catch (...) {
+            lock.lock();
+            eraseInflightLocked(key, ticket);
+            lock.unlock();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        lock.lock();
+        eraseInflightLocked(key, ticket);
+        // Don't cache failures (including 4xx/5xx Status bodies) or anything fetched before an invalidate()
+        if (ttl.count() > 0 && response.ok() && startGeneration == generation) {
+            cache[key] = CacheEntry{response, Clock::now() + ttl};
+        }
+        lock.unlock();
+        promise.set_value(response);
+        return response;
+    }
+
+    // Drops cached responses whose key starts with prefix, and detaches
+    // matching in-flight fetches so later callers start a fresh one instead of
+    // joining a fetch that may predate the write. Call after a write so the
+    // next read observes it.
+    void invalidate(const std::string& prefix = "") {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+        for (auto it = cache.begin(); it != cache.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (auto it = inflight.begin(); it != inflight.end();) {
+            if (it->first.compare(0, prefix.size(), prefix) == 0) {
+                it = inflight.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    const Stats& getStats() const {
+        return stats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct CacheEntry {
+        HTTPResponse response;
+        Clock::time_point expires;
+    };
+
+    struct InflightFetch {
+        uint64_t ticket;  // Identifies the fetch, since an invalidate() may have replaced it
+        std::shared_future<HTTPResponse> result;
+    };
+
+    std::chrono::milliseconds ttl;
+    std::mutex mutex;
+    std::unordered_map<std::string, InflightFetch> inflight;
+    std::unordered_map<std::string, CacheEntry> cache;
+    uint64_t generation = 0;
+    uint64_t nextTicket = 0;
+    Stats stats;
+
+    // Removes key's in-flight entry only if it is still this fetch's
+    void eraseInflightLocked(const std::string& key, uint64_t ticket) {
+        auto found = inflight.find(key);
+        if (found != inflight.end() && found->second.ticket == ticket) {
+            inflight.erase(found);
+        }
+    }
+};
+
+// Process-wide coalescer used for GETs. The TTL is kept short so interactive
+// commands still see changes made by other clients almost immediately. Its
+// stats are exported with the API metrics.
+inline RequestCoalescer& getRequestCoalescer() {
+    static RequestCoalescer coalescer(std::chrono::milliseconds(500));
+    static bool registered = [] {
+        const RequestCoalescer::Stats& stats = coalescer.getStats();
+        ApiMetrics& metrics = ApiMetrics::instance();
+        metrics.registerCounter("k8s_api_coalescer_hits_total", "GETs served from the coalescer's TTL cache",
+                                [&stats] { return stats.hits.load(std::memory_order_relaxed); });
+        metrics.registerCounter("k8s_api_coalescer_misses_total", "GETs the coalescer sent to the API server",
+                                [&stats] { return stats.misses.load(std::memory_order_relaxed); });
+        metrics.registerCounter("k8s_api_coalescer_joined_total", "GETs that waited on an identical in-flight GET",
+                                [&stats] { return stats.joined.load(std::memory_order_relaxed); });
+        return true;
+    }();
+    (void)registered;
+    return coalescer;
+}
+
+// GET through the coalescer, keyed by the full URL (including any label
+// selector) and the bearer token, so callers never share a response fetched
+// with someone else's credentials, including a token that has since been
+// rotated out. The URL comes first so invalidate(apiServer) still matches.
+// Only 2xx responses are cached; callers must check ok() before using the body.
+inline HTTPResponse makeCoalescedGET(const std::string& url, const std::string& token) {
+    return getRequestCoalescer().get(url + "\n" + token, [&] { return performHTTPRequest(url, token, "GET"); });
+}
+
+// Mutating request that invalidates cached reads under the same API server
+inline HTTPResponse makeMutatingRequest(const std::string& apiServer, const std::string& url, const std::string& token,
+                                       const std::string& method, const std::string& body = "") {
+    HTTPResponse response = performHTTPRequest(url, token, method, body);
+    getRequestCoalescer().invalidate(apiServer);
+    return response;
+}
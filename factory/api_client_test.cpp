@@ -0,0 +1,157 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+#include "api_client.h"
+#include "mock_api_server.h"
+#include "test_check.h"
+
+HTTPResponse okResponse(const std::string& body) {
+    HTTPResponse response;
+    response.body = body;
+    response.status = 200;
+    return response;
+}
+
+// Waits until count reaches target, so a test can tell a fetch has started
+void waitFor(const std::atomic<int>& count, int target) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (count.load() < target && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+int main() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Concurrent callers for one key share a single fetch
+    {
+        RequestCoalescer coalescer;
+        std::promise<void> release;
+        std::shared_future<void> gate = release.get_future().share();
+        std::atomic<int> fetches{0};
+        std::vector<std::future<HTTPResponse>> callers;
+        for (int i = 0; i < 8; ++i) {
+            callers.push_back(std::async(std::launch::async, [&] {
+                return coalescer.get("key", [&] {
+                    ++fetches;
+                    gate.wait();
+                    return okResponse("shared");
+                });
+            }));
+        }
+        waitFor(fetches, 1);
+        while (coalescer.getStats().joined.load() < 7) {
+            std::this_thread::yield();
+        }
+        release.set_value();
+        for (auto& caller : callers) {
+            check(caller.get().body == "shared", "every caller gets the shared response");
+        }
+        check(fetches.load() == 1, "single-flight: 8 callers, " + std::to_string(fetches.load()) + " fetches");
+        check(coalescer.getStats().misses.load() == 1 && coalescer.getStats().joined.load() == 7,
+              "one miss and seven joins are counted");
+    }
+
+    // Responses are cached for the TTL, then fetched again
+    {
+        RequestCoalescer coalescer(std::chrono::milliseconds(50));
+        int fetches = 0;
+        auto fetch = [&] {
+            ++fetches;
+            return okResponse("v" + std::to_string(fetches));
+        };
+        check(coalescer.get("key", fetch).body == "v1", "first get fetches");
+        check(coalescer.get("key", fetch).body == "v1" && fetches == 1, "second get within the TTL is a hit");
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        check(coalescer.get("key", fetch).body == "v2" && fetches == 2, "expired entry is fetched again");
+        check(coalescer.getStats().hits.load() == 1, "hits are counted");
+    }
+
+    // Error responses are returned with their status but never cached
+    {
+        RequestCoalescer coalescer(std::chrono::milliseconds(1000));
+        int fetches = 0;
+        auto fetch = [&] {
+            ++fetches;
+            HTTPResponse response;
+            response.body = R"({"kind":"Status","code":503})";
+            response.status = 503;
+            return response;
+        };
+        HTTPResponse first = coalescer.get("key", fetch);
+        check(first.status == 503 && !first.ok(), "status is passed through to the caller");
+        coalescer.get("key", fetch);
+        check(fetches == 2, "a 5xx Status body is not cached");
+    }
+
+    // invalidate() detaches an in-flight fetch: later callers start their own,
+    // and the stale one neither caches its result nor removes the new entry
+    {
+        RequestCoalescer coalescer(std::chrono::milliseconds(1000));
+        std::promise<void> releaseStale;
+        std::promise<void> releaseFresh;
+        std::shared_future<void> staleGate = releaseStale.get_future().share();
+        std::shared_future<void> freshGate = releaseFresh.get_future().share();
+        std::atomic<int> fetches{0};
+        auto stale = std::async(std::launch::async, [&] {
+            return coalescer.get("http://server/pods", [&] {
+                ++fetches;
+                staleGate.wait();
+                return okResponse("stale");
+            });
+        });
+        waitFor(fetches, 1);
+        coalescer.invalidate("http://server");
+        auto fresh = std::async(std::launch::async, [&] {
+            return coalescer.get("http://server/pods", [&] {
+                ++fetches;
+                freshGate.wait();
+                return okResponse("fresh");
+            });
+        });
+        waitFor(fetches, 2);
+        check(fetches.load() == 2, "a get after invalidate() doesn't join the older fetch");
+
+        releaseStale.set_value();
+        check(stale.get().body == "stale", "the detached fetch still answers its own caller");
+        auto joiner = std::async(std::launch::async, [&] {
+            return coalescer.get("http://server/pods", [&] {
+                ++fetches;
+                return okResponse("third");
+            });
+        });
+        while (coalescer.getStats().joined.load() < 1) {
+            std::this_thread::yield();
+        }
+        releaseFresh.set_value();
+        check(fresh.get().body == "fresh" && joiner.get().body == "fresh",
+              "the stale fetch finishing leaves the fresh in-flight entry in place");
+        check(coalescer.get("http://server/pods", [] { return okResponse("fourth"); }).body == "fresh",
+              "the fresh response is cached, the stale one is not");
+    }
+
+    // Callers with different tokens never share a response
+    {
+        MockApiServer server;
+        server.addNamespace("default");
+        std::string url = server.url() + "/api/v1/namespaces";
+        const RequestCoalescer::Stats& stats = getRequestCoalescer().getStats();
+        uint64_t misses = stats.misses.load();
+        uint64_t hits = stats.hits.load();
+        check(makeCoalescedGET(url, "token-a").ok(), "GET through the coalescer succeeds");
+        makeCoalescedGET(url, "token-b");
+        check(stats.misses.load() - misses == 2, "a second token misses instead of reusing the first's response");
+        makeCoalescedGET(url, "token-a");
+        check(stats.hits.load() - hits == 1, "the same token hits the cache");
+        check(ApiMetrics::instance().renderPrometheus().find("k8s_api_coalescer_hits_total ") != std::string::npos,
+              "coalescer stats are exported with the API metrics");
+    }
+
+    curl_global_cleanup();
+    return testResult();
+}
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+// Per-call instrumentation for the API client. Every thread records into its
+// own shard with plain relaxed stores (it is the only writer), so the request
+// path never takes a lock or contends on a cache line. Exporters sum across
+// shards.
+
+enum class ApiVerb { Get, Post, Put, Patch, Delete, Other, Count };
+enum class ApiKind { Pods, Namespaces, NetworkPolicies, Services, Other, Count };
+enum class ApiPhase { DNS, Connect, TLS, TTFB, Total, Count };
+
+inline ApiVerb apiVerbFromMethod(const std::string& method) {
+    if (method == "GET") return ApiVerb::Get;
+    if (method == "POST") return ApiVerb::Post;
+    if (method == "PUT") return ApiVerb::Put;
+    if (method == "PATCH") return ApiVerb::Patch;
+    if (method == "DELETE") return ApiVerb::Delete;
+    return ApiVerb::Other;
+}
+
+// The kind is the last resource-type segment in the path, so
+// /api/v1/namespaces/default/pods/mypod is "pods" and /api/v1/namespaces is "namespaces".
+inline ApiKind apiKindFromURL(const std::string& url) {
+    std::string::size_type schemeEnd = url.find("://");
+    std::string::size_type pathStart = url.find('/', schemeEnd == std::string::npos ? 0 : schemeEnd + 3);
+    if (pathStart == std::string::npos) {
+        return ApiKind::Other;
+    }
+    std::string path = url.substr(pathStart, url.find('?', pathStart) - pathStart);
+
+    ApiKind kind = ApiKind::Other;
+    std::stringstream segments(path);
+    std::string segment;
+    while (std::getline(segments, segment, '/')) {
+        if (segment == "pods") kind = ApiKind::Pods;
+        else if (segment == "namespaces") kind = ApiKind::Namespaces;
+        else if (segment == "networkpolicies") kind = ApiKind::NetworkPolicies;
+        else if (segment == "services") kind = ApiKind::Services;
+    }
+    return kind;
+}
+
+inline const char* apiVerbName(size_t verb) {
+    static const char* names[] = {"GET", "POST", "PUT", "PATCH", "DELETE", "OTHER"};
+    return names[verb];
+}
+
+inline const char* apiKindName(size_t kind) {
+    static const char* names[] = {"pods", "namespaces", "networkpolicies", "services", "other"};
+    return names[kind];
+}
+
+inline const char* apiPhaseName(size_t phase) {
+    static const char* names[] = {"dns", "connect", "tls", "ttfb", "total"};
+    return names[phase];
+}
+
+// Log-linear (HDR-style) histogram of microsecond latencies: values below 16
+// get their own bucket, above that each power of two is split into 8
+// sub-buckets, giving ~12% worst-case relative error up to ~12 days.
+class LatencyHistogram {
+public:
+    static constexpr size_t kLinearBuckets = 16;
+    static constexpr size_t kSubBuckets = 8;
+    static constexpr size_t kMaxExponent = 40;
+    static constexpr size_t kBucketCount = kLinearBuckets + (kMaxExponent - 4) * kSubBuckets;
+
+    static size_t bucketIndex(uint64_t micros) {
+        if (micros < kLinearBuckets) {
+            return static_cast<size_t>(micros);
+        }
+        size_t msb = 63 - __builtin_clzll(micros);
+        if (msb >= kMaxExponent) {
+            return kBucketCount - 1;
+        }
+        size_t sub = (micros >> (msb - 3)) & (kSubBuckets - 1);
+        return kLinearBuckets + (msb - 4) * kSubBuckets + sub;
+    }
+
+    // Smallest value that maps to the given bucket
+    static uint64_t bucketLowerBound(size_t index) {
+        if (index < kLinearBuckets) {
+            return index;
+        }
+        size_t msb = (index - kLinearBuckets) / kSubBuckets + 4;
+        size_t sub = (index - kLinearBuckets) % kSubBuckets;
+        return (uint64_t(kSubBuckets) | sub) << (msb - 3);
+    }
+
+    // Single-writer update: only the owning thread calls record()
+    void record(uint64_t micros) {
+        bump(buckets[bucketIndex(micros)], 1);
+        bump(count, 1);
+        bump(sum, micros);
+    }
+
+    void mergeInto(std::vector<uint64_t>& totals, uint64_t& totalCount, uint64_t& totalSum) const {
+        totals.resize(kBucketCount, 0);
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            totals[i] += buckets[i].load(std::memory_order_relaxed);
+        }
+        totalCount += count.load(std::memory_order_relaxed);
+        totalSum += sum.load(std::memory_order_relaxed);
+    }
+
+    static void bump(std::atomic<uint64_t>& value, uint64_t delta) {
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+};
+
+struct ApiCallTiming {
+    uint64_t dnsMicros = 0;
+    uint64_t connectMicros = 0;
+    uint64_t tlsMicros = 0;
+    uint64_t ttfbMicros = 0;
+    uint64_t totalMicros = 0;
+};
+
+class ApiMetrics {
+public:
+    static ApiMetrics& instance() {
+        static ApiMetrics metrics;
+        return metrics;
+    }
+
+    void recordCall(ApiVerb verb, ApiKind kind, const ApiCallTiming& timing, bool failed) {
+        Shard& shard = localShard();
+        size_t v = static_cast<size_t>(verb);
+        size_t k = static_cast<size_t>(kind);
+        LatencyHistogram::bump(shard.requests[v][k], 1);
+        if (failed) {
+            LatencyHistogram::bump(shard.errors[v][k], 1);
+            lastFailedCall() = FailedCall{verb, kind};
+        }
+        shard.totalLatency[v][k].record(timing.totalMicros);
+        shard.phaseLatency[static_cast<size_t>(ApiPhase::DNS)].record(timing.dnsMicros);
+        shard.phaseLatency[static_cast<size_t>(ApiPhase::Connect)].record(timing.connectMicros);
+        shard.phaseLatency[static_cast<size_t>(ApiPhase::TLS)].record(timing.tlsMicros);
+        shard.phaseLatency[static_cast<size_t>(ApiPhase::TTFB)].record(timing.ttfbMicros);
+        shard.phaseLatency[static_cast<size_t>(ApiPhase::Total)].record(timing.totalMicros);
+    }
+
+    void recordRetry(ApiVerb verb, ApiKind kind) {
+        LatencyHistogram::bump(localShard().retries[static_cast<size_t>(verb)][static_cast<size_t>(kind)], 1);
+    }
+
+    // For callers that retry a whole unit of work (e.g. a reconcile that made
+    // several calls): clear before the attempt, then on failure attribute the
+    // retry to the last call that failed on this thread, or OTHER/other if
+    // the attempt failed without a failed call.
+    void clearLastFailure() {
+        lastFailedCall() = FailedCall();
+    }
+
+    void recordRetryOfLastFailure() {
+        FailedCall& last = lastFailedCall();
+        recordRetry(last.verb, last.kind);
+        last = FailedCall();
+    }
+
+    // Adds a counter maintained elsewhere (e.g. cache stats) to the exposition.
+    // read is called on every render and must be thread-safe.
+    void registerCounter(const std::string& name, const std::string& help, std::function<uint64_t()> read) {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        externalCounters.push_back(ExternalCounter{name, help, std::move(read)});
+    }
+
+    // Prometheus text exposition format. Latencies are exported in seconds
+    // using a fixed set of "le" bounds folded from the fine-grained buckets.
+    std::string renderPrometheus() const {
+        std::vector<std::shared_ptr<Shard>> shards = snapshotShards();
+        std::ostringstream out;
+
+        writeCounter(out, shards, "k8s_api_requests_total", "API requests issued", &Shard::requests);
+        writeCounter(out, shards, "k8s_api_errors_total", "API requests that failed in curl or returned a non-2xx status", &Shard::errors);
+        writeCounter(out, shards, "k8s_api_retries_total", "API requests retried", &Shard::retries);
+
+        out << "# HELP k8s_api_request_duration_seconds Total API request latency\n";
+        out << "# TYPE k8s_api_request_duration_seconds histogram\n";
+        for (size_t v = 0; v < kVerbs; ++v) {
+            for (size_t k = 0; k < kKinds; ++k) {
+                std::vector<uint64_t> buckets;
+                uint64_t count = 0, sum = 0;
+                for (const auto& shard : shards) {
+                    shard->totalLatency[v][k].mergeInto(buckets, count, sum);
+                }
+                if (count == 0) {
+                    continue;
+                }
+                std::string labels = std::string("verb=\"") + apiVerbName(v) + "\",kind=\"" + apiKindName(k) + "\"";
+                writeHistogram(out, "k8s_api_request_duration_seconds", labels, buckets, count, sum);
+            }
+        }
+
+        out << "# HELP k8s_api_phase_duration_seconds API request latency by curl phase\n";
+        out << "# TYPE k8s_api_phase_duration_seconds histogram\n";
+        for (size_t p = 0; p < kPhases; ++p) {
+            std::vector<uint64_t> buckets;
+            uint64_t count = 0, sum = 0;
+            for (const auto& shard : shards) {
+                shard->phaseLatency[p].mergeInto(buckets, count, sum);
+            }
+            if (count == 0) {
+                continue;
+            }
+            writeHistogram(out, "k8s_api_phase_duration_seconds", std::string("phase=\"") + apiPhaseName(p) + "\"",
+                           buckets, count, sum);
+        }
+
+        for (const auto& counter : snapshotExternalCounters()) {
+            out << "# HELP " << counter.name << " " << counter.help << "\n";
+            out << "# TYPE " << counter.name << " counter\n";
+            out << counter.name << " " << counter.read() << "\n";
+        }
+        return out.str();
+    }
+
+    // Writes renderPrometheus() to path via a temp file and rename, so a
+    // node-exporter textfile collector never reads a partial file.
+    bool dumpToFile(const std::string& path) const {
+        std::string tmpPath = path + ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::trunc);
+            if (!file) {
+                return false;
+            }
+            file << renderPrometheus();
+            if (!file) {
+                return false;
+            }
+        }
+        return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+    }
+
+private:
+    struct FailedCall {
+        ApiVerb verb = ApiVerb::Other;
+        ApiKind kind = ApiKind::Other;
+    };
+
+    static FailedCall& lastFailedCall() {
+        thread_local FailedCall last;
+        return last;
+    }
+
+    static constexpr size_t kVerbs = static_cast<size_t>(ApiVerb::Count);
+    static constexpr size_t kKinds = static_cast<size_t>(ApiKind::Count);
+    static constexpr size_t kPhases = static_cast<size_t>(ApiPhase::Count);
+
+    using CounterGrid = std::array<std::array<std::atomic<uint64_t>, kKinds>, kVerbs>;
+
+    struct alignas(64) Shard {
+        CounterGrid requests{};
+        CounterGrid errors{};
+        CounterGrid retries{};
+        std::array<std::array<LatencyHistogram, kKinds>, kVerbs> totalLatency;
+        std::array<LatencyHistogram, kPhases> phaseLatency;
+    };
+
+    struct ExternalCounter {
+        std::string name;
+        std::string help;
+        std::function<uint64_t()> read;
+    };
+
+    mutable std::mutex shardsMutex;
+    std::vector<std::shared_ptr<Shard>> shards;
+    std::vector<ExternalCounter> externalCounters;
+
+    // The registry keeps shards alive after their thread exits so counts
+    // from short-lived workers are not lost.
+    Shard& localShard() {
+        thread_local std::shared_ptr<Shard> shard = [this] {
+            auto created = std::make_shared<Shard>();
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            shards.push_back(created);
+            return created;
+        }();
+        return *shard;
+    }
+
+    std::vector<std::shared_ptr<Shard>> snapshotShards() const {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        return shards;
+    }
+
+    std::vector<ExternalCounter> snapshotExternalCounters() const {
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        return externalCounters;
+    }
+
+    static void writeCounter(std::ostringstream& out, const std::vector<std::shared_ptr<Shard>>& shards,
+                             const char* name, const char* help, CounterGrid Shard::*grid) {
+        out << "# HELP " << name << " " << help << "\n";
+        out << "# TYPE " << name << " counter\n";
+        for (size_t v = 0; v < kVerbs; ++v) {
+            for (size_t k = 0; k < kKinds; ++k) {
+                uint64_t total = 0;
+                for (const auto& shard : shards) {
+                    total += ((*shard).*grid)[v][k].load(std::memory_order_relaxed);
+                }
+                if (total > 0) {
+                    out << name << "{verb=\"" << apiVerbName(v) << "\",kind=\"" << apiKindName(k) << "\"} " << total << "\n";
+                }
+            }
+        }
+    }
+
+    static void writeHistogram(std::ostringstream& out, const std::string& name, const std::string& labels,
+                               const std::vector<uint64_t>& buckets, uint64_t count, uint64_t sum) {
+        static const uint64_t boundsMicros[] = {1000, 2500, 5000, 10000, 25000, 50000, 100000,
+                                                250000, 500000, 1000000, 2500000, 5000000, 10000000};
+        size_t bucket = 0;
+        uint64_t cumulative = 0;
+        for (uint64_t bound : boundsMicros) {
+            // A fine bucket counts toward "le" once its whole range is at or below the bound
+            while (bucket + 1 < buckets.size() && LatencyHistogram::bucketLowerBound(bucket + 1) <= bound + 1) {
+                cumulative += buckets[bucket++];
+            }
+            out << name << "_bucket{" << labels << ",le=\"" << bound / 1e6 << "\"} " << cumulative << "\n";
+        }
+        out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << count << "\n";
+        out << name << "_sum{" << labels << "} " << sum / 1e6 << "\n";
+        out << name << "_count{" << labels << "} " << count << "\n";
+    }
+};
+
+// Rewrites the metrics file every interval from a background thread, and
+// once more on destruction so work finished after the last tick (e.g. by
+// workers draining at shutdown) is not lost.
+class MetricsDumper {
+public:
+    MetricsDumper(std::string path, std::chrono::milliseconds interval)
+        : path(std::move(path)), interval(interval), thread([this] { run(); }) {}
+
+    ~MetricsDumper() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+        ApiMetrics::instance().dumpToFile(path);
+    }
+
+    MetricsDumper(const MetricsDumper&) = delete;
+    MetricsDumper& operator=(const MetricsDumper&) = delete;
+
+private:
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    std::thread thread;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wakeup.wait_for(lock, interval, [this] { return stopping; })) {
+            lock.unlock();
+            ApiMetrics::instance().dumpToFile(path);
+            lock.lock();
+        }
+    }
+};
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "api_metrics.h"
+#include "test_check.h"
+
+// Value of the k8s_api_request_duration_seconds bucket for PATCH services at
+// the given "le", or -1 if the line is missing
+long long bucketCount(const std::string& exposition, const std::string& le) {
+    std::string prefix = "k8s_api_request_duration_seconds_bucket{verb=\"PATCH\",kind=\"services\",le=\"" + le + "\"} ";
+    std::string::size_type at = exposition.find(prefix);
+    if (at == std::string::npos) {
+        return -1;
+    }
+    return std::stoll(exposition.substr(at + prefix.size()));
+}
+
+void recordPatch(uint64_t totalMicros, bool failed = false) {
+    ApiCallTiming timing;
+    timing.totalMicros = totalMicros;
+    ApiMetrics::instance().recordCall(ApiVerb::Patch, ApiKind::Services, timing, failed);
+}
+
+int main() {
+    // Every value maps to a bucket whose lower bound is at or below it, the
+    // next bucket starts above it, and the relative error stays under 1/8
+    {
+        bool bounded = true;
+        bool precise = true;
+        for (uint64_t v = 0; v < (1u << 20); v += 1 + v / 64) {
+            size_t index = LatencyHistogram::bucketIndex(v);
+            uint64_t lower = LatencyHistogram::bucketLowerBound(index);
+            bounded = bounded && lower <= v && LatencyHistogram::bucketLowerBound(index + 1) > v;
+            precise = precise && (v - lower) * 8 <= v;
+        }
+        check(bounded, "bucketLowerBound(bucketIndex(v)) <= v < bucketLowerBound(bucketIndex(v) + 1)");
+        check(precise, "bucket lower bounds are within 12.5% of the value");
+    }
+    {
+        bool linear = true;
+        for (uint64_t v = 0; v < LatencyHistogram::kLinearBuckets; ++v) {
+            linear = linear && LatencyHistogram::bucketIndex(v) == v && LatencyHistogram::bucketLowerBound(v) == v;
+        }
+        check(linear, "values below 16 get their own bucket");
+        bool increasing = true;
+        for (size_t i = 1; i < LatencyHistogram::kBucketCount; ++i) {
+            increasing = increasing && LatencyHistogram::bucketLowerBound(i) > LatencyHistogram::bucketLowerBound(i - 1);
+            increasing = increasing && LatencyHistogram::bucketIndex(LatencyHistogram::bucketLowerBound(i)) == i;
+        }
+        check(increasing, "bucket lower bounds increase and map back to their bucket");
+        check(LatencyHistogram::bucketIndex(UINT64_MAX) == LatencyHistogram::kBucketCount - 1,
+              "huge values land in the last bucket");
+    }
+
+    // A fine bucket is folded into an "le" only once its whole range fits:
+    // 900us ([896,959]) is under 1ms, 1000us ([960,1023]) first counts at
+    // 2.5ms, and 2400us ([2304,2559]) first counts at 5ms
+    {
+        recordPatch(900);
+        recordPatch(1000);
+        recordPatch(2400, true);
+        std::string exposition = ApiMetrics::instance().renderPrometheus();
+        check(bucketCount(exposition, "0.001") == 1, "le=0.001 holds only the 900us call");
+        check(bucketCount(exposition, "0.0025") == 2, "le=0.0025 adds the 1000us call but not the 2400us one");
+        check(bucketCount(exposition, "0.005") == 3, "le=0.005 holds all three calls");
+        check(bucketCount(exposition, "10") == 3 && bucketCount(exposition, "+Inf") == 3, "upper buckets are cumulative");
+        check(exposition.find("k8s_api_request_duration_seconds_sum{verb=\"PATCH\",kind=\"services\"} 0.0043\n") !=
+                  std::string::npos,
+              "sum is exported in seconds");
+        check(exposition.find("k8s_api_errors_total{verb=\"PATCH\",kind=\"services\"} 1\n") != std::string::npos,
+              "failed calls are counted as errors");
+    }
+
+    // The dumper writes a final file on destruction, without waiting for a tick
+    {
+        const std::string path = "api_metrics_test.prom";
+        std::remove(path.c_str());
+        {
+            MetricsDumper dumper(path, std::chrono::hours(1));
+            recordPatch(50);
+        }
+        std::ifstream file(path);
+        std::stringstream contents;
+        contents << file.rdbuf();
+        check(bucketCount(contents.str(), "0.001") == 2, "final dump includes calls recorded after the last tick");
+        std::remove(path.c_str());
+    }
+
+    return testResult();
+}
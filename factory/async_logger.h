@@ -0,0 +1,400 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Asynchronous logger. Producers push records into a per-thread ring buffer
+// without locking; a background thread drains all rings and does the
+// formatting and I/O. Element dumps are captured as raw fields and only
+// formatted on the flusher thread. Whatever is still queued when the process
+// dies through std::terminate is written out before it aborts.
+
+enum class LogLevel { Trace = 0, Debug = 1, Info = 2, Warn = 3, Error = 4, Off = 5 };
+
+// Levels below this are compiled out of the LOG_* macros
+#ifndef FACTORY_LOG_LEVEL
+#define FACTORY_LOG_LEVEL 2
+#endif
+
+inline const char* logLevelName(LogLevel level) {
+    static const char* names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+    return names[static_cast<int>(level)];
+}
+
+// Unformatted copy of an Element's fields
+struct ElementFields {
+    std::string kind;
+    std::string name;
+    std::string namespace_;
+    std::string creationTimestamp;
+    std::vector<std::pair<std::string, std::string>> labels;
+    std::vector<std::pair<std::string, std::string>> annotations;
+};
+
+struct LogRecord {
+    LogLevel level = LogLevel::Info;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+    std::unique_ptr<ElementFields> element;
+};
+
+class LogSink {
+public:
+    virtual ~LogSink() = default;
+    virtual void write(const LogRecord& record) = 0;
+    virtual void flush() = 0;
+};
+
+// Human-readable lines in the same layout printInfo has always used.
+// Warnings and errors can go to a separate stream, e.g. std::cerr.
+class TextLogSink : public LogSink {
+public:
+    explicit TextLogSink(std::ostream& out) : out(out), errors(out) {}
+    TextLogSink(std::ostream& out, std::ostream& errors) : out(out), errors(errors) {}
+
+    void write(const LogRecord& record) override {
+        std::ostream& stream = record.level >= LogLevel::Warn ? errors : out;
+        if (!record.message.empty()) {
+            stream << record.message;
+        }
+        if (record.element) {
+            const ElementFields& e = *record.element;
+            stream << "Kind: " << e.kind << ", Name: " << e.name;
+            if (!e.namespace_.empty()) {
+                stream << ", Namespace: " << e.namespace_;
+            }
+            stream << ", CreationTimestamp: " << e.creationTimestamp << ", Labels: ";
+            for (const auto& label : e.labels) {
+                stream << label.first << "=" << label.second << " ";
+            }
+            stream << ", Annotations: ";
+            for (const auto& annotation : e.annotations) {
+                stream << annotation.first << "=" << annotation.second << " ";
+            }
+        }
+        stream << '\n';
+    }
+
+    void flush() override {
+        out.flush();
+        errors.flush();
+    }
+
+private:
+    std::ostream& out;
+    std::ostream& errors;
+};
+
+// One JSON object per line, for log shippers
+class JsonLogSink : public LogSink {
+public:
+    explicit JsonLogSink(std::ostream& out) : out(out) {}
+
+    void write(const LogRecord& record) override {
+        nlohmann::json j;
+        j["ts"] = std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+        j["level"] = logLevelName(record.level);
+        if (!record.message.empty()) {
+            j["msg"] = record.message;
+        }
+        if (record.element) {
+            const ElementFields& e = *record.element;
+            j["kind"] = e.kind;
+            j["name"] = e.name;
+            if (!e.namespace_.empty()) {
+                j["namespace"] = e.namespace_;
+            }
+            j["creationTimestamp"] = e.creationTimestamp;
+            for (const auto& label : e.labels) {
+                j["labels"][label.first] = label.second;
+            }
+            for (const auto& annotation : e.annotations) {
+                j["annotations"][annotation.first] = annotation.second;
+            }
+        }
+        out << j.dump() << '\n';
+    }
+
+    void flush() override {
+        out.flush();
+    }
+
+private:
+    std::ostream& out;
+};
+
+// Compact length-prefixed records: [u8 level][i64 micros][str msg][u8 hasElement]
+// then, if present, four strings followed by [u32 n] key/value pairs for labels
+// and annotations. Strings are [u32 length][bytes], little-endian host order.
+class BinaryLogSink : public LogSink {
+public:
+    explicit BinaryLogSink(std::ostream& out) : out(out) {}
+
+    void write(const LogRecord& record) override {
+        uint8_t level = static_cast<uint8_t>(record.level);
+        int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(record.time.time_since_epoch()).count();
+        writeRaw(level);
+        writeRaw(micros);
+        writeString(record.message);
+        uint8_t hasElement = record.element ? 1 : 0;
+        writeRaw(hasElement);
+        if (record.element) {
+            const ElementFields& e = *record.element;
+            writeString(e.kind);
+            writeString(e.name);
+            writeString(e.namespace_);
+            writeString(e.creationTimestamp);
+            writePairs(e.labels);
+            writePairs(e.annotations);
+        }
+    }
+
+    void flush() override {
+        out.flush();
+    }
+
+private:
+    std::ostream& out;
+
+    template <typename T>
+    void writeRaw(const T& value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(const std::string& value) {
+        uint32_t length = static_cast<uint32_t>(value.size());
+        writeRaw(length);
+        out.write(value.data(), length);
+    }
+
+    void writePairs(const std::vector<std::pair<std::string, std::string>>& pairs) {
+        uint32_t count = static_cast<uint32_t>(pairs.size());
+        writeRaw(count);
+        for (const auto& pair : pairs) {
+            writeString(pair.first);
+            writeString(pair.second);
+        }
+    }
+};
+
+class AsyncLogger {
+public:
+    static constexpr size_t kRingCapacity = 1024;  // Records per thread; power of two
+
+    static AsyncLogger& instance() {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    ~AsyncLogger() {
+        running.store(false);
+        if (flusher.joinable()) {
+            flusher.join();
+        }
+        drain();
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    void setSink(std::unique_ptr<LogSink> newSink) {
+        std::lock_guard<std::mutex> lock(drainMutex);
+        sink = std::move(newSink);
+    }
+
+    void setLevel(LogLevel level) {
+        minLevel.store(level, std::memory_order_relaxed);
+    }
+
+    bool enabled(LogLevel level) const {
+        return level >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    template <typename... Args>
+    void log(LogLevel level, Args&&... args) {
+        if (!enabled(level)) {
+            return;
+        }
+        LogRecord record;
+        record.level = level;
+        record.time = std::chrono::system_clock::now();
+        (appendPart(record.message, std::forward<Args>(args)), ...);
+        push(std::move(record));
+    }
+
+    // Captures the fields of any Element-like object; formatting happens on
+    // the flusher thread in whatever form the sink wants.
+    template <typename E>
+    void logElement(LogLevel level, const E& element, std::string message = "") {
+        if (!enabled(level)) {
+            return;
+        }
+        LogRecord record;
+        record.level = level;
+        record.time = std::chrono::system_clock::now();
+        record.message = std::move(message);
+        record.element = std::make_unique<ElementFields>();
+        record.element->kind = element.kind;
+        record.element->name = element.name;
+        record.element->namespace_ = element.namespace_;
+        record.element->creationTimestamp = element.creationTimestamp;
+        record.element->labels.assign(element.labels.begin(), element.labels.end());
+        record.element->annotations.assign(element.annotations.begin(), element.annotations.end());
+        push(std::move(record));
+    }
+
+    // Blocks until everything logged so far has reached the sink
+    void flush() {
+        drain();
+    }
+
+    uint64_t droppedCount() const {
+        return dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Single-producer/single-consumer ring owned by one logging thread
+    struct Ring {
+        std::array<LogRecord, kRingCapacity> slots;
+        alignas(64) std::atomic<size_t> head{0};  // Next slot to read, advanced by the flusher
+        alignas(64) std::atomic<size_t> tail{0};  // Next slot to write, advanced by the owner
+    };
+
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::mutex drainMutex;  // Serializes consumers: the flusher thread and flush()
+    std::unique_ptr<LogSink> sink;
+    std::atomic<LogLevel> minLevel{static_cast<LogLevel>(FACTORY_LOG_LEVEL)};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::thread flusher;
+
+    AsyncLogger() : sink(std::make_unique<TextLogSink>(std::cout, std::cerr)) {
+        flusher = std::thread([this] { flushLoop(); });
+        previousTerminate() = std::set_terminate(onTerminate);
+    }
+
+    static std::terminate_handler& previousTerminate() {
+        static std::terminate_handler handler = nullptr;
+        return handler;
+    }
+
+    // Drains what is queued (most usefully the error that led here), then
+    // hands over to the previous handler. Gives up on the drain if another
+    // thread holds the sink for too long, e.g. if it is the one terminating.
+    static void onTerminate() {
+        AsyncLogger& logger = instance();
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            std::unique_lock<std::mutex> lock(logger.drainMutex, std::try_to_lock);
+            if (lock.owns_lock()) {
+                logger.drainLocked(logger.snapshotRings());
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::terminate_handler previous = previousTerminate();
+        if (previous) {
+            previous();
+        }
+        std::abort();
+    }
+
+    static void appendPart(std::string& out, const std::string& part) { out += part; }
+    static void appendPart(std::string& out, const char* part) { out += part; }
+    static void appendPart(std::string& out, char part) { out += part; }
+
+    template <typename T>
+    static std::enable_if_t<std::is_arithmetic<T>::value> appendPart(std::string& out, T part) {
+        out += std::to_string(part);
+    }
+
+    Ring& localRing() {
+        thread_local std::shared_ptr<Ring> ring = [this] {
+            auto created = std::make_shared<Ring>();
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(created);
+            return created;
+        }();
+        return *ring;
+    }
+
+    // Never blocks the caller: when the ring is full the record is dropped and counted
+    void push(LogRecord&& record) {
+        Ring& ring = localRing();
+        size_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (tail - ring.head.load(std::memory_order_acquire) >= kRingCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring.slots[tail & (kRingCapacity - 1)] = std::move(record);
+        ring.tail.store(tail + 1, std::memory_order_release);
+    }
+
+    std::vector<std::shared_ptr<Ring>> snapshotRings() {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        return rings;
+    }
+
+    size_t drain() {
+        std::vector<std::shared_ptr<Ring>> snapshot = snapshotRings();
+        std::lock_guard<std::mutex> lock(drainMutex);
+        return drainLocked(snapshot);
+    }
+
+    // Caller holds drainMutex
+    size_t drainLocked(const std::vector<std::shared_ptr<Ring>>& snapshot) {
+        size_t written = 0;
+        for (const auto& ring : snapshot) {
+            size_t head = ring->head.load(std::memory_order_relaxed);
+            size_t tail = ring->tail.load(std::memory_order_acquire);
+            for (; head != tail; ++head) {
+                LogRecord& record = ring->slots[head & (kRingCapacity - 1)];
+                if (sink) {
+                    sink->write(record);
+                }
+                record.element.reset();
+                record.message.clear();
+                ++written;
+            }
+            ring->head.store(head, std::memory_order_release);
+        }
+        if (written > 0 && sink) {
+            sink->flush();
+        }
+        return written;
+    }
+
+    void flushLoop() {
+        while (running.load()) {
+            if (drain() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            }
+        }
+    }
+};
+
+#define FACTORY_LOG(level, ...)                                              \
+    do {                                                                     \
+        if constexpr (static_cast<int>(level) >= FACTORY_LOG_LEVEL) {        \
+            AsyncLogger::instance().log(level, __VA_ARGS__);                 \
+        }                                                                    \
+    } while (0)
+
+#define LOG_DEBUG(...) FACTORY_LOG(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) FACTORY_LOG(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...) FACTORY_LOG(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) FACTORY_LOG(LogLevel::Error, __VA_ARGS__)
@@ -1,85 +1,165 @@
 #include <iostream>
 #include <fstream>
+#include <optional>
+#include <stdexcept>
 #include <string>
-#include <curl/curl.h>
 #include <nholmann/json.hpp>
+#include "config.h"
+#include "api_client.h"
+#include "work_queue.h"
+#include "policy_engine.h"
+#include "pod_manifest.h"
+#include "journal.h"
 
 using json = nlohmann::json;
 
 
 
-// Callback function for libcurl to write the response data
-size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
-    ((std::string*)userp)->append((char*)contents, size * nmemb);
-    return size * nmemb;
+// Function to read JSON from a file
+json readJSONFromFile(const std::string& filePath) {
+    std::ifstream file(filePath);
+    json jsonData;
+    file >> jsonData;
+    return jsonData;
 }
 
-// Function to make an HTTP request using libcurl
-std::string makeHTTPRequest(const std::string& url, const std::string& token, const std::string& method, const std::string& body = "") {
-    CURL* curl;
-    CURLcode res;
-    std::string readBuffer;
-
-    curl = curl_easy_init();
-    if (curl) {
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, ("Authorization: Bearer " + token).c_str());
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
-
-        if (method == "POST" || method == "PUT") {
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+// GETs url through the coalescer and parses the body. Throws if the request
+// failed or returned a non-2xx Status, so callers never read an error body as
+// an empty list and conclude that something is absent.
+json getJSON(const std::string& url, const std::string& token) {
+    HTTPResponse response = makeCoalescedGET(url, token);
+    if (!response.ok()) {
+        throw std::runtime_error("GET " + url + " failed: HTTP " + std::to_string(response.status));
+    }
+    return json::parse(response.body);
+}
+
+// Local model of the cluster's namespaces, pods and NetworkPolicies, used to
+// check a move before it is applied. It is loaded from the API server on the
+// first check and then kept current from this process's own writes, so a check
+// doesn't cost three cluster-wide LISTs. A pod the model hasn't seen (created
+// by another client) triggers one reload.
+class ConnectivityGuard {
+public:
+    // Throws if any of the LISTs fails, keeping the previous model, rather than
+    // judging moves against an empty one built from error bodies
+    void load(const std::string& apiServer, const std::string& token) {
+        PolicyEngine fresh;
+        json namespaces = getJSON(apiServer + "/api/v1/namespaces", token);
+        for (const auto& ns : namespaces["items"]) {
+            fresh.upsertNamespace(ns["metadata"]["name"], labelsOf(ns));
+        }
+        json pods = getJSON(apiServer + "/api/v1/pods", token);
+        for (const auto& pod : pods["items"]) {
+            fresh.upsertPod(pod["metadata"]["namespace"], pod["metadata"]["name"], labelsOf(pod));
         }
+        json policies = getJSON(apiServer + "/apis/networking.k8s.io/v1/networkpolicies", token);
+        for (const auto& policy : policies["items"]) {
+            fresh.upsertPolicy(policy);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        engine = std::move(fresh);
+        loaded = true;
+    }
+
+    void podCreated(const json& manifest) {
+        std::lock_guard<std::mutex> lock(mutex);
+        engine.upsertPod(manifest["metadata"]["namespace"], manifest["metadata"]["name"], labelsOf(manifest));
+    }
+
+    void podDeleted(const std::string& namespaceName, const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        engine.removePod(namespaceName, name);
+    }
 
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);  // Only for local development
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);  // Only for local development
+    void policyCreated(const json& manifest) {
+        std::lock_guard<std::mutex> lock(mutex);
+        engine.upsertPolicy(manifest);
+    }
 
-        res = curl_easy_perform(curl);
-        if (res != CURLE_OK) {
-            std::cerr << "curl_easy_perform() failed: " << curl_easy_strerror(res) << std::endl;
+    // Logs how moving podKey to targetNamespace changes its connectivity on
+    // every port the policies tell apart. Returns false if the move would cut
+    // any existing connection; throws if the model can't be loaded.
+    bool checkMove(const std::string& apiServer, const std::string& token, const std::string& podKey,
+                   const std::string& targetNamespace) {
+        bool known;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            known = loaded && engine.hasPod(podKey);
+        }
+        if (!known) {
+            load(apiServer, token);
         }
 
-        curl_easy_cleanup(curl);
-        curl_slist_free_all(headers);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!engine.hasPod(podKey)) {
+            LOG_WARN("Pod ", podKey, " not found in the cluster, skipping connectivity check");
+            return true;
+        }
+        bool safe = true;
+        for (const auto& port : engine.representativePorts()) {
+            MoveImpact impact = engine.simulateMove(podKey, targetNamespace, port.second, port.first);
+            if (impact.lostIngress.empty() && impact.lostEgress.empty()) {
+                LOG_INFO("Moving ", podKey, " to ", targetNamespace, " on ", port.first, "/", port.second, ": gains ",
+                         impact.gainedIngress.size(), " inbound and ", impact.gainedEgress.size(), " outbound peers");
+            } else {
+                LOG_WARN("Moving ", podKey, " to ", targetNamespace, " on ", port.first, "/", port.second, ": loses ",
+                         impact.lostIngress.size(), " inbound and ", impact.lostEgress.size(), " outbound peers");
+                safe = false;
+            }
+        }
+        return safe;
     }
 
-    return readBuffer;
-}
+private:
+    std::mutex mutex;
+    PolicyEngine engine;
+    bool loaded = false;
 
-// Function to read JSON from a file
-json readJSONFromFile(const std::string& filePath) {
-    std::ifstream file(filePath);
-    json jsonData;
-    file >> jsonData;
-    return jsonData;
+    static LabelMap labelsOf(const json& object) {
+        if (!object["metadata"].contains("labels")) {
+            return LabelMap();
+        }
+        return object["metadata"]["labels"].get<LabelMap>();
+    }
+};
+
+inline ConnectivityGuard& connectivityGuard() {
+    static ConnectivityGuard guard;
+    return guard;
 }
 
 // Function to create a network policy
 void createNetworkPolicy(const std::string& apiServer, const std::string& token, const json& policySpec) {
     std::string url = apiServer + "/apis/networking.k8s.io/v1/namespaces/" + policySpec["metadata"]["namespace"].get<std::string>() + "/networkpolicies";
     std::string body = policySpec.dump();
-    makeHTTPRequest(url, token, "POST", body);
-    std::cout << "Network policy created successfully" << std::endl;
+    HTTPResponse response = makeMutatingRequest(apiServer, url, token, "POST", body);
+    if (response.ok()) {
+        connectivityGuard().policyCreated(policySpec);
+        LOG_INFO("Network policy created successfully");
+    } else {
+        LOG_ERROR("Network policy creation failed: HTTP ", response.status);
+    }
 }
 
 // Function to create a pod
-void createPod(const std::string& apiServer, const std::string& token, const json& podSpec) {
+bool createPod(const std::string& apiServer, const std::string& token, const json& podSpec) {
     std::string url = apiServer + "/api/v1/namespaces/" + podSpec["metadata"]["namespace"].get<std::string>() + "/pods";
     std::string body = podSpec.dump();
-    makeHTTPRequest(url, token, "POST", body);
-    std::cout << "Pod created successfully" << std::endl;
+    HTTPResponse response = makeMutatingRequest(apiServer, url, token, "POST", body);
+    if (response.ok()) {
+        connectivityGuard().podCreated(podSpec);
+        LOG_INFO("Pod created successfully");
+    } else {
+        LOG_ERROR("Pod creation failed: HTTP ", response.status);
+    }
+    return response.ok();
 }
 
 // Function to list pods by label
 json listPods(const std::string& apiServer, const std::string& token, const std::string& namespaceName, const std::string& labelSelector) {
     std::string url = apiServer + "/api/v1/namespaces/" + namespaceName + "/pods?labelSelector=" + labelSelector;
-    std::string response = makeHTTPRequest(url, token, "GET");
-    return json::parse(response);
+    return getJSON(url, token);
 }
 
 // Function to find a pod by unique identifier
@@ -93,45 +173,65 @@ std::string findPodByUniqueId(const json& pods, const std::string& uniqueId) {
 }
 
 // Function to delete a pod
-void deletePod(const std::string& apiServer, const std::string& token, const std::string& namespaceName, const std::string& podName) {
+bool deletePod(const std::string& apiServer, const std::string& token, const std::string& namespaceName, const std::string& podName) {
     std::string url = apiServer + "/api/v1/namespaces/" + namespaceName + "/pods/" + podName;
-    makeHTTPRequest(url, token, "DELETE");
-    std::cout << "Pod " << podName << " deleted successfully" << std::endl;
-}
-
-// Function to create a pod manifest by combining pod template and container spec
-json createPodManifest(const json& podTemplate, const json& containerSpec) {
-    json podManifest = podTemplate;
-    podManifest["spec"]["containers"].push_back(containerSpec);
-    return podManifest;
+    HTTPResponse response = makeMutatingRequest(apiServer, url, token, "DELETE");
+    if (response.ok()) {
+        connectivityGuard().podDeleted(namespaceName, podName);
+        LOG_INFO("Pod ", podName, " deleted successfully");
+    } else {
+        LOG_ERROR("Pod ", podName, " deletion failed: HTTP ", response.status);
+    }
+    return response.ok();
 }
 
 // Function to promote authorization by moving a pod to the privileged namespace
-void promoteAuthorization(const std::string& apiServer, const std::string& token, const std::string& namespaceName, const std::string& uniqueId) {
+void promoteAuthorization(const std::string& apiServer, const std::string& token, Journal& journal, const std::string& namespaceName, const std::string& uniqueId) {
     // List pods and find the one with the unique ID
-    json pods = listPods(apiServer, token, namespaceName, "app=common-app");
+    json pods;
+    try {
+        pods = listPods(apiServer, token, namespaceName, "app=common-app");
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot promote pod ", uniqueId, ": ", e.what());
+        return;
+    }
     std::string podNameToUpdate = findPodByUniqueId(pods, uniqueId);
     if (!podNameToUpdate.empty()) {
-        std::cout << "Found pod with unique ID: " << podNameToUpdate << std::endl;
-
-        // Delete the existing pod
-        deletePod(apiServer, token, namespaceName, podNameToUpdate);
+        LOG_INFO("Found pod with unique ID: ", podNameToUpdate);
 
         // Create a new pod in the privileged namespace with the same container spec
         json podTemplate = readJSONFromFile("pod-template.json");
         json containerSpec = readJSONFromFile("container-spec.json");
         podTemplate["metadata"]["namespace"] = "privileged-namespace";
         json podManifest = createConfiguredComponent(podTemplate, containerSpec, uniqueId);
-        createPod(apiServer, token, podManifest);
+
+        try {
+            if (!connectivityGuard().checkMove(apiServer, token, namespaceName + "/" + podNameToUpdate, "privileged-namespace")) {
+                LOG_ERROR("Refusing to move ", podNameToUpdate, ": it would lose existing connections");
+                return;
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR("Cannot check the move of ", podNameToUpdate, ": ", e.what());
+            return;
+        }
+
+        // Journal the move before deleting, so a crash between the delete
+        // and the create is finished on the next start
+        uint64_t operation = journal.begin(JournalOp{0, "move", uniqueId, namespaceName, podManifest});
+        if (!deletePod(apiServer, token, namespaceName, podNameToUpdate)) {
+            journal.abort(operation);
+            return;
+        }
+        if (createPod(apiServer, token, podManifest)) {
+            journal.commit(operation);
+        }
     } else {
-        std::cout << "Pod with unique ID not found" << std::endl;
+        LOG_WARN("Pod with unique ID not found");
     }
 }
 // Function to list all namespaces
 std::vector<std::string> listNamespaces(const std::string& apiServer, const std::string& token) {
-    std::string url = apiServer + "/api/v1/namespaces";
-    std::string response = makeHTTPRequest(url, token, "GET");
-    json namespaces = json::parse(response);
+    json namespaces = getJSON(apiServer + "/api/v1/namespaces", token);
     std::vector<std::string> namespaceList;
     for (const auto& ns : namespaces["items"]) {
         namespaceList.push_back(ns["metadata"]["name"]);
@@ -139,49 +239,168 @@ std::vector<std::string> listNamespaces(const std::string& apiServer, const std:
     return namespaceList;
 }
 
-// Function to search for a pod with a unique ID across all namespaces
+// Function to search for a pod with a unique ID across all namespaces. A pod
+// with a deletionTimestamp is already being deleted, so it counts as gone: a
+// move whose delete was accepted must not be mistaken for one that never ran.
+// Returns "" only when every namespace answered; throws if any lookup failed,
+// since the pod may be in the namespace that couldn't be read.
 std::string findPodNamespace(const std::string& apiServer, const std::string& token, const std::string& uniqueId) {
     std::vector<std::string> namespaces = listNamespaces(apiServer, token);
     for (const auto& ns : namespaces) {
-        std::string url = apiServer + "/api/v1/namespaces/" + ns + "/pods?labelSelector=unique-id=" + uniqueId;
-        std::string response = makeHTTPRequest(url, token, "GET");
-        json pods = json::parse(response);
-        if (!pods["items"].empty()) {
-            return ns;
+        json pods = getJSON(apiServer + "/api/v1/namespaces/" + ns + "/pods?labelSelector=unique-id=" + uniqueId, token);
+        for (const auto& pod : pods["items"]) {
+            if (!pod["metadata"].contains("deletionTimestamp")) {
+                return ns;
+            }
         }
     }
     return "";
 }
 
 
-json configureContainerSpec(json containerSpec, int& id, std::string& name){
-  containerSpec["name"] = "common-app-" + std::to_string(id);
- // containerSpec[""]
- return containerSpec;
+// Creates every manifest, journaling all of them up front in one sync so a
+// crash part way through is finished on the next start
+void createPods(const std::string& apiServer, const std::string& token, Journal& journal, const std::vector<json>& manifests) {
+    std::vector<JournalOp> ops;
+    for (const auto& manifest : manifests) {
+        ops.push_back(JournalOp{0, "create", manifest["metadata"]["labels"]["unique-id"], "", manifest});
+    }
+    std::vector<uint64_t> operations = journal.begin(std::move(ops));
+    for (size_t i = 0; i < manifests.size(); ++i) {
+        if (createPod(apiServer, token, manifests[i])) {
+            journal.commit(operations[i]);
+        } else {
+            journal.abort(operations[i]);
+        }
+    }
 }
 
-json configurePodSpec(json podSpec, int&id){
-  podSpec["metadata"]["name"] = "common-pod-" + std::to_string(id);
-  podSpec["metadata"]["labels"]["unique-id"] =  std::to_string(id);
-  podSpec["metadata"]["labels"]["app"] = "common-app"; // generic name for content of pod. standardized as common app in this example model 
-  return podSpec;
-}
+// Finishes an operation the journal found unfinished at startup. A delete is
+// redone if the pod is still there. Otherwise, if the pod is already where the
+// manifest puts it, the operation completed; if it is gone or terminating, the
+// create is redone; if it is still live in its old namespace the delete never
+// happened, so the move is rolled back. Returns false if the cluster couldn't
+// be reached, leaving the operation for the next start.
+bool resumeOperation(const std::string& apiServer, const std::string& token, Journal& journal, const JournalOp& op) {
+    std::string currentNamespace;
+    try {
+        currentNamespace = findPodNamespace(apiServer, token, op.uniqueId);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Cannot resume ", op.kind, " of pod ", op.uniqueId, ": ", e.what());
+        return false;
+    }
 
-json createConfiguredComponent(json podSpec, json containerSpec, std::string & id){
-  json podManifest = podSpec;
-  containerSpec["name"] = "common-app-" + id;
-  podManifest["metadata"]["name"] = "common-pod-" + id;
-  podManifest["metadata"]["labels"]["unique-id"] = id;
-  podManifest["metadata"]["labels"]["app"] = "common-app"; // generic name for content of pod. standardized as common app in this example model 
-  podManifest["spec"]["containers"].push_back(containerSpec);
-  return podManifest;
+    if (op.kind == "delete") {
+        if (!currentNamespace.empty()) {
+            LOG_INFO("Resuming delete of pod ", op.uniqueId, " from ", currentNamespace);
+            if (!deletePod(apiServer, token, currentNamespace, "common-pod-" + op.uniqueId)) {
+                return false;
+            }
+        }
+        journal.commit(op.id);
+        return true;
+    }
+    std::string targetNamespace = op.manifest["metadata"]["namespace"];
+
+    if (currentNamespace == targetNamespace) {
+        journal.commit(op.id);
+        return true;
+    }
+    if (!currentNamespace.empty()) {
+        LOG_WARN("Rolling back ", op.kind, " of pod ", op.uniqueId, ", still in ", currentNamespace);
+        journal.abort(op.id);
+        return true;
+    }
+    LOG_INFO("Resuming ", op.kind, " of pod ", op.uniqueId, " into ", targetNamespace);
+    if (!createPod(apiServer, token, op.manifest)) {
+        return false;
+    }
+    journal.commit(op.id);
+    return true;
 }
 
+// Desired state of a pod, keyed by unique-id. The menu records intent here and
+// enqueues the key; reconcilePod makes the cluster match whatever is latest.
+struct DesiredPod {
+    bool present = true;
+    std::string namespaceName = "default-namespace";
+    bool allowConnectivityLoss = false;  // Apply a move even if it cuts existing connections
+};
+
+// Moves the cluster one step toward the desired state. Returns false (or
+// throws, if the pod's current namespace can't be determined) when any API
+// call failed, so the work queue retries the key with backoff. A move that
+// would cut existing connections is refused unless the desired state allows it;
+// retrying wouldn't change that, so it counts as done.
+bool reconcilePod(const std::string& apiServer, const std::string& token, Journal& journal, const std::string& uniqueId, const DesiredPod& desired) {
+    std::string currentNamespace = findPodNamespace(apiServer, token, uniqueId);
+    std::string podName = "common-pod-" + uniqueId;
+
+    if (!desired.present) {
+        // Journaled even when the pod is already gone, so it supersedes a
+        // create or move left open by a failed createPod; otherwise the next
+        // start would resume that and bring the pod back.
+        uint64_t operation = journal.begin(JournalOp{0, "delete", uniqueId, currentNamespace, json::object()});
+        if (!currentNamespace.empty() && !deletePod(apiServer, token, currentNamespace, podName)) {
+            return false;
+        }
+        journal.commit(operation);
+        return true;
+    }
+    if (currentNamespace == desired.namespaceName) {
+        return true;
+    }
+    json podTemplate = readJSONFromFile("pod-template.json");
+    json containerSpec = readJSONFromFile("container-spec.json");
+    podTemplate["metadata"]["namespace"] = desired.namespaceName;
+    json podManifest = createConfiguredComponent(podTemplate, containerSpec, uniqueId);
+    if (currentNamespace.empty()) {
+        // Journaled too, so it supersedes an earlier move of this pod whose
+        // create failed. Like a move, it stays open if the create fails, so a
+        // restart before the retry still recreates the pod.
+        uint64_t operation = journal.begin(JournalOp{0, "create", uniqueId, "", podManifest});
+        if (!createPod(apiServer, token, podManifest)) {
+            return false;
+        }
+        journal.commit(operation);
+        return true;
+    }
+
+    // Moving is delete-then-create; journal it so a crash in between doesn't
+    // lose the pod. If the create fails the operation stays open, and the
+    // retry finds the pod gone and journals a create that supersedes it.
+    if (!connectivityGuard().checkMove(apiServer, token, currentNamespace + "/" + podName, desired.namespaceName) &&
+        !desired.allowConnectivityLoss) {
+        LOG_ERROR("Refusing to move ", podName, " to ", desired.namespaceName,
+                  ": it would lose existing connections (choose the override to force it)");
+        return true;
+    }
+    uint64_t operation = journal.begin(JournalOp{0, "move", uniqueId, currentNamespace, podManifest});
+    if (!deletePod(apiServer, token, currentNamespace, podName)) {
+        journal.abort(operation);
+        return false;
+    }
+    if (!createPod(apiServer, token, podManifest)) {
+        return false;
+    }
+    journal.commit(operation);
+    return true;
+}
 
 // Main function to demonstrate usage
 int main() {
-    std::string apiServer = "https://127.0.0.1:16443";  // For MicroK8s running locally
-    std::string token = "<YOUR_BEARER_TOKEN>";  // Replace with your actual token
+    // Server and token come from config.json and are reloaded when it changes,
+    // so the token can be rotated without restarting.
+    ConfigWatcher configWatcher("config.json");
+    configWatcher.start();
+    std::string apiServer = configWatcher.current()->server_domain;
+    std::string token = configWatcher.current()->token;
+
+    // Finish whatever a previous run left half done before taking new commands
+    Journal journal("factory.journal");
+    for (const auto& op : journal.unfinished()) {
+        resumeOperation(apiServer, token, journal, op);
+    }
 
     // Read JSON data from files
     json privilegedPolicy = readJSONFromFile("privileged-policy.json");
@@ -193,14 +412,37 @@ int main() {
     createNetworkPolicy(apiServer, token, privilegedPolicy);
     createNetworkPolicy(apiServer, token, defaultPolicy);
 
-    // Create an example pod in the default namespace
-    
-    json podManifestApp1 = createConfiguredComponent(podSpec, containerSpec, 1);
-    createPod(apiServer, token, podManifestApp1);
-    json podManifestApp2 = createConfiguredComponent(podSpec, containerSpec, 2);
-    createPod(apiServer, token, podManifestApp2);
-    json podManifestApp3 = createConfiguredComponent(podSpec, containerSpec, 3);
-    createPod(apiServer, token, podManifestApp3);
+    // Create example pods in the default namespace
+    std::vector<json> exampleManifests;
+    for (int id = 1; id <= 3; ++id) {
+        exampleManifests.push_back(createConfiguredComponent(podTemplate, containerSpec, std::to_string(id)));
+    }
+    createPods(apiServer, token, journal, exampleManifests);
+
+    // Keep the textfile-collector dump fresh while workers run. Declared
+    // before the reconciler so its final dump runs after the workers stop.
+    MetricsDumper metricsDumper("api-metrics.prom", std::chrono::seconds(5));
+
+    // Commands only record desired state; workers reconcile it in the
+    // background, collapse repeated commands for the same pod and retry failures.
+    std::mutex desiredMutex;
+    std::unordered_map<std::string, DesiredPod> desiredPods;
+    WorkQueue workQueue;
+    std::optional<Reconciler> reconciler;
+    reconciler.emplace(workQueue, [&](const std::string& uniqueId) {
+        DesiredPod desired;
+        {
+            std::lock_guard<std::mutex> lock(desiredMutex);
+            auto found = desiredPods.find(uniqueId);
+            if (found == desiredPods.end()) {
+                return true;
+            }
+            desired = found->second;
+        }
+        // Take one snapshot per reconcile so every request it makes agrees
+        auto config = configWatcher.current();
+        return reconcilePod(config->server_domain, config->token, journal, uniqueId, desired);
+    });
 
     while (true) {
         std::cout << "Choose an option:\n";
@@ -225,43 +467,67 @@ int main() {
         switch (choice) {
             case 1: {
                 // Add a pod
-                json podTemplate = readJSONFromFile("pod-template.json");
-                json containerSpec = readJSONFromFile("container-spec.json");
-                json newPodManifest = createConfiguredComponent(podTemplate, containerSpec, uniqueId);
-                createPod(apiServer, token, newPodManifest);
+                std::lock_guard<std::mutex> lock(desiredMutex);
+                desiredPods[uniqueId] = DesiredPod();
                 break;
             }
             case 2: {
                 // Remove a pod
-                std::string namespaceName = findPodNamespace(apiServer, token, uniqueId); // Find namespace of pod to identify delete target
-                std::string podName = "common-pod-" + uniqueId;
-                deletePod(apiServer, token, namespaceName, podName);
+                std::lock_guard<std::mutex> lock(desiredMutex);
+                desiredPods[uniqueId].present = false;
                 break;
             }
             case 3: {
-                // Promote authorization of a pod
-                // Get current network policy
-                // Add condition to check if policy is demoting or promoting. 
-                std::string currentNamespace = findPodNamespace(apiServer, token, uniqueId);
-                std::string newNamespace = "";
-                if (namespaceName = "priveleged-namespace"){
-                  newNamespace = "default-namespace";
-                  promoteAuthorization(apiServer, token, newNamespace, uniqueId);
-                } else if (namespaceName = "default-namespace"){
-                  newNamespace = "priveleged-namespace";
-                  promoteAuthorization(apiServer, token, newNamespace, uniqueId);
-                }  // Change as needed
+                // Promote/Demote authorization of a pod by flipping its namespace.
+                // Start from the pending desired state if there is one, else from the cluster.
+                std::string currentNamespace;
+                {
+                    std::lock_guard<std::mutex> lock(desiredMutex);
+                    auto found = desiredPods.find(uniqueId);
+                    if (found != desiredPods.end() && found->second.present) {
+                        currentNamespace = found->second.namespaceName;
+                    }
+                }
+                if (currentNamespace.empty()) {
+                    auto config = configWatcher.current();
+                    try {
+                        currentNamespace = findPodNamespace(config->server_domain, config->token, uniqueId);
+                    } catch (const std::exception& e) {
+                        LOG_ERROR("Cannot look up pod ", uniqueId, ": ", e.what());
+                        break;
+                    }
+                }
+                if (currentNamespace.empty()) {
+                    LOG_WARN("Pod with unique ID not found");
+                    break;
+                }
+                DesiredPod desired;
+                desired.namespaceName = currentNamespace == "privileged-namespace" ? "default-namespace" : "privileged-namespace";
+                std::cout << "Move even if it cuts existing connections? (1 = yes, 0 = no): ";
+                int allowLoss = 0;
+                std::cin >> allowLoss;
+                desired.allowConnectivityLoss = allowLoss == 1;
+                std::lock_guard<std::mutex> lock(desiredMutex);
+                desiredPods[uniqueId] = desired;
                 break;
             }
             default:
                 std::cout << "Invalid choice. Please try again.\n";
                 break;
         }
+        if (choice >= 1 && choice <= 3) {
+            workQueue.add(uniqueId);
+        }
     }
 
 
     // Promote authorization by moving the pod to the privileged namespace
-    promoteAuthorization(apiServer, token, "default-namespace",  podManifestApp1["metadata"]["labels"]["unique-id"], podManifestApp1["spec"]["containers"]);
+    // Stop the workers first (they finish keys already queued; pending
+    // retries are dropped) so this can't act on a key a worker still holds
+    reconciler.reset();
+    auto config = configWatcher.current();
+    promoteAuthorization(config->server_domain, config->token, journal, "default-namespace",
+                         exampleManifests[0]["metadata"]["labels"]["unique-id"]);
 
     return 0;
 }
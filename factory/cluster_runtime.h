@@ -0,0 +1,353 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "api_client.h"
+#include "async_logger.h"
+#include "config.h"
+#include "elementFactor.h"
+
+// Runtime hosting many clusters in one process. Each ClusterContext owns its
+// own connection pool, informer cache and rate limiter; all clusters share
+// one fixed pool of worker threads. Workers pick clusters round-robin and a
+// cluster may only occupy a bounded number of workers at once, so a slow or
+// rate-limited cluster can't starve the others.
+
+// Reusable curl handles for one API server. Keeping handles alive keeps
+// their connections alive, so steady-state requests skip the handshake.
+class ConnectionPool {
+public:
+    class Handle {
+    public:
+        Handle(ConnectionPool& pool, CURL* curl) : pool(pool), curl(curl) {}
+        ~Handle() {
+            pool.release(curl);
+        }
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        CURL* get() const {
+            return curl;
+        }
+
+    private:
+        ConnectionPool& pool;
+        CURL* curl;
+    };
+
+    ~ConnectionPool() {
+        for (CURL* curl : idle) {
+            curl_easy_cleanup(curl);
+        }
+    }
+
+    Handle acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!idle.empty()) {
+            CURL* curl = idle.back();
+            idle.pop_back();
+            return Handle(*this, curl);
+        }
+        CURL* curl = curl_easy_init();
+        if (!curl) {
+            throw std::runtime_error("curl_easy_init failed");
+        }
+        return Handle(*this, curl);
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<CURL*> idle;
+
+    void release(CURL* curl) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idle.push_back(curl);
+    }
+};
+
+// Token bucket: refills at qps tokens per second up to burst
+class RateLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    RateLimiter(double qps, double burst) : qps(qps), burst(burst), tokens(burst), last(Clock::now()) {}
+
+    // Takes a token if one is available; otherwise returns false and sets
+    // readyAt to when the next token will be.
+    bool tryAcquire(Clock::time_point now, Clock::time_point& readyAt) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (qps <= 0) {
+            return true;  // Unlimited
+        }
+        tokens = std::min(burst, tokens + std::chrono::duration<double>(now - last).count() * qps);
+        last = now;
+        if (tokens >= 1.0) {
+            tokens -= 1.0;
+            return true;
+        }
+        readyAt = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>((1.0 - tokens) / qps));
+        return false;
+    }
+
+private:
+    std::mutex mutex;
+    double qps;
+    double burst;
+    double tokens;
+    Clock::time_point last;
+};
+
+// Local copy of the cluster's pods, refreshed by resync(). Readers take a
+// shared lock; a resync builds the new map off to the side and swaps it in.
+class InformerCache {
+public:
+    using PodMap = std::unordered_map<std::string, std::shared_ptr<const Element>>;
+
+    void replace(std::vector<std::unique_ptr<Element>> elements) {
+        auto next = std::make_shared<PodMap>();
+        for (auto& element : elements) {
+            std::string key = element->namespace_ + "/" + element->name;
+            (*next)[key] = std::shared_ptr<const Element>(std::move(element));
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        pods = std::move(next);
+    }
+
+    std::shared_ptr<const Element> get(const std::string& key) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto found = pods->find(key);
+        return found == pods->end() ? nullptr : found->second;
+    }
+
+    // Consistent view of every cached pod as of the last resync
+    std::shared_ptr<const PodMap> snapshot() const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return pods;
+    }
+
+private:
+    mutable std::shared_mutex mutex;
+    std::shared_ptr<const PodMap> pods = std::make_shared<PodMap>();
+};
+
+struct ClusterOptions {
+    double qps = 50;              // Tasks started per second on this cluster; <= 0 disables
+    double burst = 100;
+    size_t maxInFlight = 0;       // Workers this cluster may hold at once; 0 = fair share, workers / clusters rounded up
+};
+
+class ClusterContext {
+public:
+    ClusterContext(std::string name, std::shared_ptr<const Configuration> config, const ClusterOptions& options)
+        : name(std::move(name)), options(options), limiter(options.qps, options.burst), config(std::move(config)) {}
+
+    const std::string name;
+    const ClusterOptions options;
+    ConnectionPool connections;
+    InformerCache informer;
+    RateLimiter limiter;
+
+    std::shared_ptr<const Configuration> currentConfig() const {
+        return config.load();
+    }
+
+    // Swap in new credentials or server URL; in-flight calls keep the old snapshot
+    void updateConfig(std::shared_ptr<const Configuration> next) {
+        config.store(std::move(next));
+    }
+
+    HTTPResponse request(const std::string& path, const std::string& method, const std::string& body = "") {
+        auto snapshot = currentConfig();
+        ConnectionPool::Handle handle = connections.acquire();
+        return performHTTPRequest(handle.get(), snapshot->server_domain + path, snapshot->token, method, body);
+    }
+
+    // Relists every pod in the cluster into the informer cache
+    bool resync() {
+        HTTPResponse response = request("/api/v1/pods", "GET");
+        if (!response.ok()) {
+            LOG_WARN("Informer resync failed for cluster ", name, ": HTTP ", response.status);
+            return false;
+        }
+        informer.replace(ElementFactory::createElementList(response.body));
+        return true;
+    }
+
+    uint64_t completedTasks() const {
+        return completed.load(std::memory_order_relaxed);
+    }
+
+private:
+    friend class ClusterRuntime;
+
+    SnapshotCell<Configuration> config;
+    std::deque<std::function<void(ClusterContext&)>> tasks;  // Guarded by ClusterRuntime::mutex
+    size_t inFlight = 0;                                      // Guarded by ClusterRuntime::mutex
+    std::atomic<uint64_t> completed{0};
+};
+
+class ClusterRuntime {
+public:
+    using Task = std::function<void(ClusterContext&)>;
+
+    explicit ClusterRuntime(size_t workerCount = std::thread::hardware_concurrency())
+        : workerTotal(std::max<size_t>(workerCount, 1)) {
+        for (size_t i = 0; i < workerTotal; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ClusterRuntime() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ClusterRuntime(const ClusterRuntime&) = delete;
+    ClusterRuntime& operator=(const ClusterRuntime&) = delete;
+
+    ClusterContext& addCluster(const std::string& name, std::shared_ptr<const Configuration> config,
+                               const ClusterOptions& options = ClusterOptions()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (clusterIndex.count(name)) {
+            throw std::invalid_argument("Cluster already registered: " + name);
+        }
+        clusters.push_back(std::make_unique<ClusterContext>(name, std::move(config), options));
+        clusterIndex[name] = clusters.size() - 1;
+        return *clusters.back();
+    }
+
+    ClusterContext& cluster(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = clusterIndex.find(name);
+        if (found == clusterIndex.end()) {
+            throw std::out_of_range("Unknown cluster: " + name);
+        }
+        return *clusters[found->second];
+    }
+
+    void submit(const std::string& clusterName, Task task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto found = clusterIndex.find(clusterName);
+            if (found == clusterIndex.end()) {
+                throw std::out_of_range("Unknown cluster: " + clusterName);
+            }
+            clusters[found->second]->tasks.push_back(std::move(task));
+            ++pending;
+        }
+        wake.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return pending == 0; });
+    }
+
+    size_t workerCount() const {
+        return workerTotal;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<std::unique_ptr<ClusterContext>> clusters;
+    std::unordered_map<std::string, size_t> clusterIndex;
+    const size_t workerTotal;
+    std::vector<std::thread> workers;
+    size_t cursor = 0;   // Next cluster to consider, for round-robin
+    size_t pending = 0;  // Queued plus running tasks across all clusters
+    bool stopping = false;
+
+    size_t inFlightCap(const ClusterContext& context) const {
+        if (context.options.maxInFlight > 0) {
+            return context.options.maxInFlight;
+        }
+        size_t clusterCount = std::max<size_t>(1, clusters.size());
+        return std::max<size_t>(1, (workerTotal + clusterCount - 1) / clusterCount);
+    }
+
+    // Picks the next runnable cluster after the cursor. Must hold mutex.
+    ClusterContext* pickCluster(RateLimiter::Clock::time_point& earliestReady, bool& rateLimited) {
+        auto now = RateLimiter::Clock::now();
+        for (size_t i = 0; i < clusters.size(); ++i) {
+            size_t index = (cursor + i) % clusters.size();
+            ClusterContext& context = *clusters[index];
+            if (context.tasks.empty() || context.inFlight >= inFlightCap(context)) {
+                continue;
+            }
+            RateLimiter::Clock::time_point readyAt;
+            if (!context.limiter.tryAcquire(now, readyAt)) {
+                if (!rateLimited || readyAt < earliestReady) {
+                    earliestReady = readyAt;
+                }
+                rateLimited = true;
+                continue;
+            }
+            cursor = index + 1;
+            return &context;
+        }
+        return nullptr;
+    }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            RateLimiter::Clock::time_point earliestReady;
+            bool rateLimited = false;
+            ClusterContext* context = stopping ? nullptr : pickCluster(earliestReady, rateLimited);
+            if (!context) {
+                if (stopping) {
+                    return;
+                }
+                if (rateLimited) {
+                    wake.wait_until(lock, earliestReady);
+                } else {
+                    wake.wait(lock);
+                }
+                continue;
+            }
+
+            Task task = std::move(context->tasks.front());
+            context->tasks.pop_front();
+            ++context->inFlight;
+            lock.unlock();
+
+            try {
+                task(*context);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Task failed on cluster ", context->name, ": ", e.what());
+            }
+            context->completed.fetch_add(1, std::memory_order_relaxed);
+
+            lock.lock();
+            --context->inFlight;
+            --pending;
+            // A slot on this cluster just freed up; another worker may be able to use it
+            wake.notify_one();
+            if (pending == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,112 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cluster_runtime.h"
+#include "mock_api_server.h"
+
+// Runs three mock API servers, one of them slow, behind a four-worker
+// runtime and checks that the fast clusters finish their work without
+// waiting on the slow one.
+int main() {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    int failures = 0;
+
+    try {
+        MockApiServer fastA;
+        MockApiServer fastB;
+        MockApiServer slow(std::chrono::milliseconds(200));
+        std::vector<MockApiServer*> servers = {&fastA, &fastB, &slow};
+        for (size_t i = 0; i < servers.size(); ++i) {
+            servers[i]->addPod("default", "mypod" + std::to_string(i), R"({"kind":"Pod","metadata":{"name":"mypod)" +
+                               std::to_string(i) + R"(","namespace":"default"}})");
+        }
+
+        auto makeConfig = [](const MockApiServer& server) {
+            auto config = std::make_shared<Configuration>();
+            config->server_domain = server.url();
+            config->token = "test-token";
+            return std::shared_ptr<const Configuration>(config);
+        };
+
+        ClusterRuntime runtime(4);
+        ClusterOptions options;
+        options.qps = 0;
+        runtime.addCluster("fast-a", makeConfig(fastA), options);
+        runtime.addCluster("fast-b", makeConfig(fastB), options);
+        runtime.addCluster("slow", makeConfig(slow), options);
+
+        const int tasksPerCluster = 20;
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<int64_t> fastFinishedMillis{0};
+        std::atomic<int> fastRemaining{2 * tasksPerCluster};
+        std::atomic<int> failedRequests{0};
+        for (int i = 0; i < tasksPerCluster; ++i) {
+            for (const char* name : {"fast-a", "fast-b"}) {
+                runtime.submit(name, [&](ClusterContext& cluster) {
+                    if (!cluster.request("/api/v1/namespaces/default/pods", "GET").ok()) {
+                        std::cerr << "GET failed on " << cluster.name << std::endl;
+                        ++failedRequests;
+                    }
+                    if (--fastRemaining == 0) {
+                        fastFinishedMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+                    }
+                });
+            }
+            runtime.submit("slow", [&](ClusterContext& cluster) {
+                if (!cluster.request("/api/v1/namespaces/default/pods", "GET").ok()) {
+                    std::cerr << "GET failed on " << cluster.name << std::endl;
+                    ++failedRequests;
+                }
+            });
+        }
+        runtime.waitIdle();
+        auto totalMillis = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        // The slow cluster holds at most two of the four workers (its fair share),
+        // so its 20 x 200ms take ~2s while the fast clusters finish early.
+        std::cout << "fast clusters done in " << fastFinishedMillis << "ms, all done in " << totalMillis << "ms" << std::endl;
+        if (fastFinishedMillis * 4 > totalMillis) {
+            std::cerr << "FAIL: fast clusters were held up by the slow one" << std::endl;
+            ++failures;
+        }
+        // A fast finish is meaningless if the requests behind it failed
+        if (failedRequests.load() != 0) {
+            std::cerr << "FAIL: " << failedRequests.load() << " GET requests failed" << std::endl;
+            ++failures;
+        }
+        for (const char* name : {"fast-a", "fast-b", "slow"}) {
+            if (runtime.cluster(name).completedTasks() != static_cast<uint64_t>(tasksPerCluster)) {
+                std::cerr << "FAIL: " << name << " completed " << runtime.cluster(name).completedTasks() << std::endl;
+                ++failures;
+            }
+        }
+
+        // Each cluster's informer only sees its own server's pods. The mock
+        // lists them without a per-item kind, as a real server does.
+        for (size_t i = 0; i < servers.size(); ++i) {
+            ClusterContext& cluster = runtime.cluster(i == 0 ? "fast-a" : i == 1 ? "fast-b" : "slow");
+            if (!cluster.resync()) {
+                std::cerr << "FAIL: resync of " << cluster.name << " failed" << std::endl;
+                ++failures;
+                continue;
+            }
+            auto pod = cluster.informer.get("default/mypod" + std::to_string(i));
+            if (!pod || pod->kind != "Pod" || cluster.informer.snapshot()->size() != 1) {
+                std::cerr << "FAIL: informer cache for " << cluster.name << " is wrong" << std::endl;
+                ++failures;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        ++failures;
+    }
+
+    curl_global_cleanup();
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
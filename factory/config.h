@@ -1,6 +1,21 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
 #include <string>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include "async_logger.h"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
 
 using json = nlohmann::json;
 
@@ -12,9 +27,13 @@ public:
     std::string pod_url;
     std::string namespace_url;
     std::string networkpolicy_url;
+    json raw; // Full document, for keys not mapped to a field above
 
     void loadConfig(const std::string& configFilePath) {
         std::ifstream configFile(configFilePath);
+        if (!configFile) {
+            throw std::runtime_error("Cannot open config file: " + configFilePath);
+        }
         json configJson;
         configFile >> configJson;
 
@@ -24,5 +43,195 @@ public:
         pod_url = configJson.value("pod_url", "/pods");
         namespace_url = configJson.value("namespace_url", "/namespaces");
         networkpolicy_url = configJson.value("networkpolicy_url", "/networkpolicies");
+        raw = std::move(configJson);
+    }
+
+    static std::shared_ptr<const Configuration> fromFile(const std::string& configFilePath) {
+        auto config = std::make_shared<Configuration>();
+        config->loadConfig(configFilePath);
+        return config;
+    }
+};
+
+// Publishes immutable snapshots of T to many readers. std::atomic_load on a
+// shared_ptr is not lock-free in libstdc++ (it goes through a global mutex
+// pool), so each thread keeps a small cache of the snapshots it has seen,
+// tagged with a version number. load() checks the cell's atomic version
+// against that cache and copies the cached pointer, which needs only atomic
+// loads and a refcount increment. The mutex is taken only by store() and by
+// the first load() on each thread after a store().
+template <typename T>
+class SnapshotCell {
+public:
+    explicit SnapshotCell(std::shared_ptr<const T> initial = nullptr) : id(nextSerial()) {
+        store(std::move(initial));
+    }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    std::shared_ptr<const T> load() const {
+        CacheEntry& entry = cache()[id % kCacheSlots];
+        if (entry.version == version.load(std::memory_order_acquire)) {
+            return entry.value;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        entry.version = version.load(std::memory_order_relaxed);
+        entry.value = value;
+        return entry.value;
+    }
+
+    void store(std::shared_ptr<const T> next) {
+        std::lock_guard<std::mutex> lock(mutex);
+        value = std::move(next);
+        version.store(nextSerial(), std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kCacheSlots = 16;
+
+    struct CacheEntry {
+        uint64_t version = 0;
+        std::shared_ptr<const T> value;
+    };
+
+    // Versions come from one process-wide counter, so a cache entry can only
+    // match the cell and publication it was filled from
+    static uint64_t nextSerial() {
+        static std::atomic<uint64_t> serial{0};
+        return serial.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    static std::array<CacheEntry, kCacheSlots>& cache() {
+        thread_local std::array<CacheEntry, kCacheSlots> entries;
+        return entries;
+    }
+
+    const uint64_t id;
+    mutable std::mutex mutex;
+    std::shared_ptr<const T> value;
+    std::atomic<uint64_t> version{0};
+};
+
+// Holds the current Configuration as an immutable snapshot and swaps in a new
+// one whenever the file changes on disk. Readers call current() and keep the
+// returned pointer for the duration of a request, so a reload never changes
+// the token or URLs underneath an in-flight call.
+class ConfigWatcher {
+public:
+    using ReloadCallback = std::function<void(const std::shared_ptr<const Configuration>&)>;
+
+    explicit ConfigWatcher(const std::string& configFilePath)
+        : path(configFilePath), snapshot(Configuration::fromFile(configFilePath)) {}
+
+    ~ConfigWatcher() {
+        stop();
+    }
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    std::shared_ptr<const Configuration> current() const {
+        return snapshot.load();
+    }
+
+    // Re-parses the file and publishes the result. A file that fails to parse
+    // (e.g. caught mid-write) leaves the previous snapshot in place.
+    bool reload() {
+        try {
+            auto next = Configuration::fromFile(path);
+            snapshot.store(next);
+            ReloadCallback callback;
+            {
+                std::lock_guard<std::mutex> lock(callbackMutex);
+                callback = onReload;
+            }
+            if (callback) {
+                callback(next);
+            }
+            return true;
+        } catch (const std::exception& e) {
+            LOG_WARN("Config reload failed, keeping previous: ", e.what());
+            return false;
+        }
+    }
+
+    // Safe to call while the watcher is running; a reload already in progress
+    // may still invoke the previous callback
+    void setReloadCallback(ReloadCallback callback) {
+        std::lock_guard<std::mutex> lock(callbackMutex);
+        onReload = std::move(callback);
+    }
+
+    // Starts watching the file's directory with inotify. The directory is
+    // watched rather than the file so that editors that replace the file via
+    // rename are picked up as well. Kubernetes ConfigMap and Secret volumes
+    // never touch config.json itself: they swap the "..data" symlink it
+    // points through, so a rename onto "..data" also triggers a reload.
+    void start() {
+        if (watcher.joinable()) {
+            return;
+        }
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) {
+            throw std::runtime_error(std::string("inotify_init1 failed: ") + std::strerror(errno));
+        }
+        std::string::size_type slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : path.substr(0, slash);
+        fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+        if (inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(inotifyFd);
+            inotifyFd = -1;
+            throw std::runtime_error("inotify_add_watch failed for " + directory + ": " + std::strerror(errno));
+        }
+        running.store(true);
+        watcher = std::thread([this] { watchLoop(); });
+    }
+
+    void stop() {
+        running.store(false);
+        if (watcher.joinable()) {
+            watcher.join();
+        }
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+            inotifyFd = -1;
+        }
+    }
+
+private:
+    std::string path;
+    std::string fileName;
+    SnapshotCell<Configuration> snapshot;
+    std::mutex callbackMutex;
+    ReloadCallback onReload;
+    int inotifyFd = -1;
+    std::atomic<bool> running{false};
+    std::thread watcher;
+
+    void watchLoop() {
+        alignas(struct inotify_event) char buffer[4096];
+        while (running.load()) {
+            pollfd pfd{inotifyFd, POLLIN, 0};
+            // Wake periodically so stop() doesn't wait on a quiet directory
+            if (poll(&pfd, 1, 500) <= 0) {
+                continue;
+            }
+            ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                continue;
+            }
+            bool changed = false;
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+                if (event->len > 0 && (fileName == event->name || std::strcmp(event->name, "..data") == 0)) {
+                    changed = true;
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+            if (changed) {
+                reload();
+            }
+        }
     }
 };
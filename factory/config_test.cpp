@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "test_check.h"
+
+// Lays out a directory the way the kubelet mounts a ConfigMap volume:
+// config.json -> ..data/config.json, ..data -> ..<generation>. Publishing a
+// generation writes a new directory and atomically renames a fresh symlink
+// over ..data, so config.json itself is never written.
+class ProjectedVolume {
+public:
+    ProjectedVolume() {
+        char pattern[] = "config_test.XXXXXX";
+        directory = mkdtemp(pattern);
+        publish(0);
+        symlink("..data/config.json", (directory + "/config.json").c_str());
+    }
+
+    ~ProjectedVolume() {
+        std::system(("rm -rf " + directory).c_str());
+    }
+
+    // server_domain and token both encode the generation, so a reader can
+    // tell a consistent snapshot from a torn one
+    void publish(int generation) {
+        std::string version = "..gen-" + std::to_string(generation);
+        mkdir((directory + "/" + version).c_str(), 0755);
+        {
+            std::ofstream file(directory + "/" + version + "/config.json");
+            file << R"({"server_domain":"https://cluster-)" << generation << R"(","token":"token-)" << generation
+                 << R"("})";
+        }
+        std::string staging = directory + "/..data_tmp";
+        std::remove(staging.c_str());
+        symlink(version.c_str(), staging.c_str());
+        std::rename(staging.c_str(), (directory + "/..data").c_str());
+    }
+
+    std::string path() const {
+        return directory + "/config.json";
+    }
+
+private:
+    std::string directory;
+};
+
+// Generation encoded in a snapshot, or -1 if its fields disagree
+int generationOf(const Configuration& config) {
+    const std::string prefix = "https://cluster-";
+    if (config.server_domain.compare(0, prefix.size(), prefix) != 0) {
+        return -1;
+    }
+    std::string generation = config.server_domain.substr(prefix.size());
+    return config.token == "token-" + generation ? std::stoi(generation) : -1;
+}
+
+int main() {
+    // Cells share a small per-thread cache; colliding slots must not mix them up
+    {
+        std::vector<std::unique_ptr<SnapshotCell<int>>> cells;
+        for (int i = 0; i < 40; ++i) {
+            cells.push_back(std::make_unique<SnapshotCell<int>>(std::make_shared<const int>(i)));
+        }
+        bool correct = true;
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 40; ++i) {
+                correct = correct && *cells[i]->load() == i + 100 * round;
+                cells[i]->store(std::make_shared<const int>(i + 100 * (round + 1)));
+            }
+        }
+        check(correct, "every cell returns its own latest value");
+    }
+
+    // Swapping ..data while readers run: every snapshot is whole, and each
+    // reader only ever moves forward
+    {
+        ProjectedVolume volume;
+        ConfigWatcher watcher(volume.path());
+        watcher.start();
+        check(generationOf(*watcher.current()) == 0, "initial snapshot is loaded");
+
+        std::atomic<bool> stop{false};
+        std::atomic<int> torn{0};
+        std::atomic<int> backwards{0};
+        std::atomic<int> reloads{0};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&] {
+                int last = 0;
+                while (!stop.load()) {
+                    int generation = generationOf(*watcher.current());
+                    if (generation < 0) {
+                        ++torn;
+                    } else if (generation < last) {
+                        ++backwards;
+                    } else {
+                        last = generation;
+                    }
+                }
+            });
+        }
+        // Replacing the callback while the watcher may be calling it
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                watcher.setReloadCallback([&](const std::shared_ptr<const Configuration>&) { ++reloads; });
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        });
+
+        const int generations = 20;
+        int picked = 0;
+        for (int generation = 1; generation <= generations; ++generation) {
+            volume.publish(generation);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+            while (generationOf(*watcher.current()) != generation && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            picked += generationOf(*watcher.current()) == generation;
+        }
+        stop.store(true);
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        watcher.stop();
+
+        check(picked == generations, "every ..data swap is picked up, got " + std::to_string(picked) + " of " +
+                                         std::to_string(generations));
+        check(torn.load() == 0, "no reader saw a torn snapshot");
+        check(backwards.load() == 0, "no reader saw an older snapshot after a newer one");
+        check(reloads.load() > 0, "the reload callback runs");
+    }
+
+    return testResult();
+}
@@ -4,17 +4,22 @@
 #include <string>
 #include "KubernetesController.h"  // Include the KubernetesController header
 #include "ElementFactory.h"  // Include the ElementFactory header
+#include "config.h"
 
 class ControllerProcessor {
 public:
-    ControllerProcessor(const std::string& configFilePath) {
+    ControllerProcessor(const std::string& configFilePath) : configWatcher(configFilePath) {
         controller = std::make_unique<KubernetesController>(configFilePath);
-        loadConfig(configFilePath);
+        configWatcher.start();
+    }
+
+    // Snapshot of the config as of this call; stays valid across reloads
+    std::shared_ptr<const Configuration> config() const {
+        return configWatcher.current();
     }
 
     void deploy(const Payload& payload) {
-        std::cout << "Deploying to " << payload.url_extension << " with data: " << std::endl;
-        payload.element->printInfo();
+        AsyncLogger::instance().logElement(LogLevel::Info, *payload.element, "Deploying to " + payload.url_extension + " with data: ");
         controller->createElement(payload.element->kind);
     }
 
@@ -33,16 +38,7 @@ public:
 
 private:
     std::unique_ptr<KubernetesController> controller;
-    std::unordered_map<std::string, std::string> config;
-
-    void loadConfig(const std::string& configFilePath) {
-        std::ifstream configFile(configFilePath);
-        json configJson;
-        configFile >> configJson;
-        for (json::iterator it = configJson.begin(); it != configJson.end(); ++it) {
-            config[it.key()] = it.value();
-        }
-    }
+    ConfigWatcher configWatcher;
 
     std::vector<std::string> listFiles(const std::string& directoryPath) {
         // Dummy implementation to list files
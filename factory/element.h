@@ -1,9 +1,12 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include <memory>
+#include "async_logger.h"
 
 using json = nlohmann::json;
 
@@ -39,16 +42,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -69,16 +63,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -98,16 +83,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name 
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -128,15 +104,6 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
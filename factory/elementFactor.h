@@ -1,9 +1,12 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 #include <nlohmann/json.hpp>
 #include <memory>
+#include "async_logger.h"
 
 using json = nlohmann::json;
 
@@ -39,16 +42,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -69,16 +63,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -98,16 +83,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name 
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -128,16 +104,7 @@ public:
     }
 
     void printInfo() const override {
-        std::cout << "Kind: " << kind << ", Name: " << name << ", Namespace: " << namespace_
-                  << ", CreationTimestamp: " << creationTimestamp << ", Labels: ";
-        for (const auto& label : labels) {
-            std::cout << label.first << "=" << label.second << " ";
-        }
-        std::cout << ", Annotations: ";
-        for (const auto& annotation : annotations) {
-            std::cout << annotation.first << "=" << annotation.second << " ";
-        }
-        std::cout << std::endl;
+        AsyncLogger::instance().logElement(LogLevel::Info, *this);
     }
 };
 
@@ -183,28 +150,33 @@ public:
         throw std::invalid_argument("Unknown kind: " + kind);
     }
 
+    // Items of a typed list from the API server (PodList, NamespaceList, ...)
+    // carry no kind of their own, so it is taken from the list's kind.
     static std::vector<std::unique_ptr<Element>> createElementList(const std::string& jsonData) {
         std::vector<std::unique_ptr<Element>> elements;
         json j = json::parse(jsonData);
+        std::string listKind = j.value("kind", "");
+        std::string itemKind;
+        if (listKind.size() > 4 && listKind.compare(listKind.size() - 4, 4, "List") == 0) {
+            itemKind = listKind.substr(0, listKind.size() - 4);
+        }
         for (const auto& item : j["items"]) {
-            std::string kind = item.value("kind", "");
+            std::string kind = item.value("kind", itemKind);
+            std::unique_ptr<Element> element;
             if (kind == "Pod") {
-                auto element = std::make_unique<Pod>();
-                element->fromJson(item);
-                elements.push_back(std::move(element));
+                element = std::make_unique<Pod>();
             } else if (kind == "Service") {
-                auto element = std::make_unique<Service>();
-                element->fromJson(item);
-                elements.push_back(std::move(element));
+                element = std::make_unique<Service>();
             } else if (kind == "Namespace") {
-                auto element = std::make_unique<Namespace>();
-                element->fromJson(item);
-                elements.push_back(std::move(element));
+                element = std::make_unique<Namespace>();
             } else if (kind == "NetworkPolicy") {
-                auto element = std::make_unique<NetworkPolicy>();
-                element->fromJson(item);
-                elements.push_back(std::move(element));
+                element = std::make_unique<NetworkPolicy>();
+            } else {
+                continue;
             }
+            element->fromJson(item);
+            element->kind = kind;
+            elements.push_back(std::move(element));
         }
         return elements;
     }
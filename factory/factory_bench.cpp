@@ -0,0 +1,271 @@
+// Benchmarks for the element factory, storage, API client and journal layers.
+//
+//   cmake -S . -B build && cmake --build build --target factory_bench
+//   build/factory_bench
+//
+// Results go to bench_results.json unless --benchmark_out is given. Compare
+// two runs with Google Benchmark's tools/compare.py:
+//
+//   compare.py benchmarks baseline.json bench_results.json
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <curl/curl.h>
+#include "api_client.h"
+#include "cluster_runtime.h"
+#include "elementFactor.h"
+#include "journal.h"
+#include "manifest_generator.h"
+#include "mock_api_server.h"
+#include "pod_manifest.h"
+#include "storage/staticstorage.h"
+
+// Args: annotation bytes
+static void BM_CreateElement(benchmark::State& state) {
+    ManifestOptions options;
+    options.annotationBytes = state.range(0);
+    std::string manifest = ManifestGenerator(options).pod(0);
+    for (auto _ : state) {
+        auto element = ElementFactory::createElement(manifest);
+        benchmark::DoNotOptimize(element);
+    }
+    state.SetBytesProcessed(state.iterations() * manifest.size());
+}
+BENCHMARK(BM_CreateElement)->Arg(64)->Arg(1024)->Arg(16384);
+
+// Args: pod count, labels per pod, distinct values per label
+static void BM_CreateElementList(benchmark::State& state) {
+    ManifestOptions options;
+    options.podCount = state.range(0);
+    options.labelKeys = state.range(1);
+    options.labelCardinality = state.range(2);
+    std::string list = ManifestGenerator(options).podList();
+    for (auto _ : state) {
+        auto elements = ElementFactory::createElementList(list);
+        benchmark::DoNotOptimize(elements);
+    }
+    state.SetItemsProcessed(state.iterations() * options.podCount);
+    state.SetBytesProcessed(state.iterations() * list.size());
+}
+BENCHMARK(BM_CreateElementList)
+    ->Args({10, 4, 16})
+    ->Args({100, 4, 16})
+    ->Args({1000, 4, 16})
+    ->Args({1000, 16, 1000})
+    ->Unit(benchmark::kMicrosecond);
+
+constexpr size_t kStorageCapacity = 4096;
+using PodStorage = StaticStorage<std::string, kStorageCapacity>;
+
+static std::vector<std::string> storageKeys(size_t count) {
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        keys.push_back("default-namespace/common-pod-" + std::to_string(i));
+    }
+    return keys;
+}
+
+// Args: entries already stored. Overwrites an existing key, so the cost is the lookup plus the copy.
+static void BM_StaticStorageSet(benchmark::State& state) {
+    auto keys = storageKeys(state.range(0));
+    auto storage = std::make_unique<PodStorage>();
+    for (const auto& key : keys) {
+        storage->set(key, key);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        storage->set(keys[i], keys[i]);
+        i = (i + 1) % keys.size();
+    }
+}
+BENCHMARK(BM_StaticStorageSet)->Arg(16)->Arg(256)->Arg(kStorageCapacity - 1);
+
+static void BM_StaticStorageGet(benchmark::State& state) {
+    auto keys = storageKeys(state.range(0));
+    auto storage = std::make_unique<PodStorage>();
+    for (const auto& key : keys) {
+        storage->set(key, key);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(storage->get(keys[i]));
+        i = (i + 1) % keys.size();
+    }
+}
+BENCHMARK(BM_StaticStorageGet)->Arg(16)->Arg(256)->Arg(kStorageCapacity - 1);
+
+// Removes and re-adds one entry; remove shifts everything after it down
+static void BM_StaticStorageRemove(benchmark::State& state) {
+    auto keys = storageKeys(state.range(0));
+    auto storage = std::make_unique<PodStorage>();
+    for (const auto& key : keys) {
+        storage->set(key, key);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        storage->remove(keys[i]);
+        storage->set(keys[i], keys[i]);
+        i = (i + 1) % keys.size();
+    }
+}
+BENCHMARK(BM_StaticStorageRemove)->Arg(16)->Arg(256)->Arg(kStorageCapacity - 1);
+
+static void BM_CreateConfiguredComponent(benchmark::State& state) {
+    json podSpec = json::parse(R"({"apiVersion":"v1","kind":"Pod","metadata":{"name":"common-pod-0",
+        "namespace":"default-namespace","labels":{"app":"common-app","unique-id":"0"}},"spec":{"containers":[]}})");
+    json containerSpec = json::parse(R"({"name":"common-container","image":"localhost:32000/common_service_app:latest",
+        "ports":[{"containerPort":8080}],"args":["0"]})");
+    int id = 0;
+    for (auto _ : state) {
+        json manifest = createConfiguredComponent(podSpec, containerSpec, std::to_string(id++));
+        benchmark::DoNotOptimize(manifest);
+    }
+}
+BENCHMARK(BM_CreateConfiguredComponent);
+
+// Shared by the HTTP benchmarks so they all measure the same server
+static MockApiServer& benchServer() {
+    static MockApiServer server;
+    static bool populated = [] {
+        ManifestOptions options;
+        ManifestGenerator generator(options);
+        for (size_t i = 0; i < options.podCount; ++i) {
+            server.addPod("default", "common-pod-" + std::to_string(i), generator.pod(i));
+        }
+        return true;
+    }();
+    (void)populated;
+    return server;
+}
+
+// A fresh handle per call, so every request pays for a new connection
+static void BM_MakeHTTPRequest(benchmark::State& state) {
+    std::string url = benchServer().url() + "/api/v1/namespaces/default/pods";
+    for (auto _ : state) {
+        std::string body = makeHTTPRequest(url, "bench-token", "GET");
+        if (body.empty()) {
+            state.SkipWithError("empty response from mock API server");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_MakeHTTPRequest)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Reuses handles from a ConnectionPool, as ClusterContext does
+static void BM_PooledHTTPRequest(benchmark::State& state) {
+    static ConnectionPool pool;
+    std::string url = benchServer().url() + "/api/v1/namespaces/default/pods";
+    for (auto _ : state) {
+        ConnectionPool::Handle handle = pool.acquire();
+        HTTPResponse response = performHTTPRequest(handle.get(), url, "bench-token", "GET");
+        if (!response.ok()) {
+            state.SkipWithError("request to mock API server failed");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_PooledHTTPRequest)->Unit(benchmark::kMicrosecond)->UseRealTime()->Threads(1)->Threads(4);
+
+static const char* kBenchJournal = "bench.journal";
+static std::unique_ptr<Journal> benchJournal;
+
+// Args: group commit window in microseconds
+static void openBenchJournal(const benchmark::State& state) {
+    std::remove(kBenchJournal);
+    benchJournal = std::make_unique<Journal>(kBenchJournal, 1 << 20, std::chrono::microseconds(state.range(0)));
+}
+
+static void closeBenchJournal(const benchmark::State&) {
+    benchJournal.reset();
+    std::remove(kBenchJournal);
+}
+
+// Parses the manifest once; callers still build ops outside the timed region
+static JournalOp benchOp(int thread, int64_t i) {
+    ManifestOptions options;
+    static const json manifest = json::parse(ManifestGenerator(options).pod(0));
+    JournalOp op;
+    op.kind = "move";
+    op.uniqueId = std::to_string(thread) + "-" + std::to_string(i);
+    op.fromNamespace = "default-namespace";
+    op.manifest = manifest;
+    return op;
+}
+
+// begin + commit as fast as the disk allows; syncs_per_op shows how much
+// group commit is sharing fdatasyncs between threads. Only begin and commit
+// are timed, not building the op.
+static void BM_JournalBeginCommit(benchmark::State& state) {
+    using Clock = std::chrono::steady_clock;
+    int64_t i = 0;
+    for (auto _ : state) {
+        JournalOp op = benchOp(state.thread_index(), i++);
+        auto start = Clock::now();
+        benchJournal->commit(benchJournal->begin(std::move(op)));
+        state.SetIterationTime(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    if (state.thread_index() == 0) {
+        Journal::Stats stats = benchJournal->stats();
+        state.counters["syncs_per_op"] = 2.0 * stats.syncs / stats.records;
+    }
+}
+BENCHMARK(BM_JournalBeginCommit)
+    ->Setup(openBenchJournal)->Teardown(closeBenchJournal)->Arg(0)->Arg(1000)
+    ->Unit(benchmark::kMicrosecond)->UseManualTime()->Threads(1)->Threads(8)->Threads(32);
+
+// Offered load of 5k operations per second spread over 16 threads. The
+// reported time is the journal's added latency per operation at that rate;
+// with no window each begin arrives alone and gets a sync to itself.
+static void BM_JournalAt5kOpsPerSec(benchmark::State& state) {
+    using Clock = std::chrono::steady_clock;
+    const auto interval = std::chrono::microseconds(1000000 * state.threads() / 5000);
+    auto next = Clock::now() + interval * state.thread_index() / state.threads();
+    int64_t i = 0;
+    for (auto _ : state) {
+        std::this_thread::sleep_until(next);
+        next += interval;
+        JournalOp op = benchOp(state.thread_index(), i++);
+        auto start = Clock::now();
+        benchJournal->commit(benchJournal->begin(std::move(op)));
+        state.SetIterationTime(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    if (state.thread_index() == 0) {
+        Journal::Stats stats = benchJournal->stats();
+        state.counters["syncs_per_op"] = 2.0 * stats.syncs / stats.records;
+    }
+}
+BENCHMARK(BM_JournalAt5kOpsPerSec)
+    ->Setup(openBenchJournal)->Teardown(closeBenchJournal)->Arg(0)->Arg(1000)
+    ->Unit(benchmark::kMicrosecond)->UseManualTime()->Threads(16)->Iterations(5000 / 16);
+
+int main(int argc, char** argv) {
+    // Default to writing JSON results so every run can be diffed
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOut = false;
+    for (int i = 1; i < argc; ++i) {
+        hasOut = hasOut || std::strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    }
+    std::string outFlag = "--benchmark_out=bench_results.json";
+    std::string formatFlag = "--benchmark_out_format=json";
+    if (!hasOut) {
+        args.push_back(outFlag.data());
+        args.push_back(formatFlag.data());
+    }
+    int count = static_cast<int>(args.size());
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    curl_global_cleanup();
+    return 0;
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "async_logger.h"
+
+using json = nlohmann::json;
+
+// A multi-step operation recorded before it starts, so a restart can tell
+// what was in flight. kind is "create" (manifest not yet created), "move"
+// (pod in fromNamespace to be deleted, then manifest created) or "delete"
+// (pod to be removed; manifest is empty).
+struct JournalOp {
+    uint64_t id = 0;
+    std::string kind;
+    std::string uniqueId;
+    std::string fromNamespace;
+    json manifest;
+};
+
+// Append-only write-ahead journal. Each operation writes a "begin" record
+// before touching the cluster and a "commit", "abort" or "superseded" record
+// afterwards.
+//
+// Records are buffered in memory and a single flusher thread writes whatever
+// has accumulated, so concurrent callers share one disk sync (group commit).
+// The flusher holds each batch open for syncWindow to let more callers join.
+// begin() waits for its record to be durable; commit() and abort() don't,
+// since losing one only means replaying an operation that is safe to redo, so
+// a batch holding only those is written without an fdatasync and reaches the
+// disk with the next one that is synced.
+//
+// Each line is "<checksum> <json>\n". Opening the journal replays it, stops at
+// the first torn or corrupt line, truncates it away, and exposes every
+// operation without an end record through unfinished(). The caller resolves
+// those and ends them with commit() or abort(). Once every operation has
+// ended, the file is truncated back to empty.
+class Journal {
+public:
+    struct Stats {
+        uint64_t records = 0;
+        uint64_t syncs = 0;
+    };
+
+    explicit Journal(const std::string& path, size_t compactBytes = 1 << 20,
+                     std::chrono::microseconds syncWindow = std::chrono::milliseconds(1))
+        : path(path), compactBytes(compactBytes), syncWindow(syncWindow) {
+        size_t validBytes = replay();
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open journal " + path + ": " + std::strerror(errno));
+        }
+        if (::ftruncate(fd, validBytes) != 0 || ::fdatasync(fd) != 0) {
+            int error = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot truncate journal " + path + ": " + std::strerror(error));
+        }
+        fileBytes = validBytes;
+        flusher = std::thread([this] { flushLoop(); });
+    }
+
+    ~Journal() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work.notify_one();
+        flusher.join();
+        ::close(fd);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Records op as started and returns its id once the record is on disk.
+    // Any earlier unfinished operation on the same uniqueId is superseded,
+    // since the new one carries the latest intent for that pod. Throws if the
+    // journal can't be written (failures are sticky, since later records may
+    // depend on the lost ones); the caller must then not start the operation.
+    uint64_t begin(JournalOp op) {
+        std::vector<JournalOp> ops;
+        ops.push_back(std::move(op));
+        return begin(std::move(ops)).front();
+    }
+
+    // Records several operations with a single wait for the disk, e.g. every
+    // pod of a bulk create before the first one is sent.
+    std::vector<uint64_t> begin(std::vector<JournalOp> ops) {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::vector<uint64_t> ids;
+        uint64_t lsn = appendedLsn;
+        for (auto& op : ops) {
+            op.id = nextId++;
+            ids.push_back(op.id);
+            lsn = appendLocked({{"id", op.id}, {"record", "begin"}, {"kind", op.kind}, {"uniqueId", op.uniqueId},
+                                {"fromNamespace", op.fromNamespace}, {"manifest", op.manifest}});
+            for (auto it = inFlight.begin(); it != inFlight.end();) {
+                if (it->second.uniqueId == op.uniqueId) {
+                    lsn = appendLocked({{"id", it->first}, {"record", "superseded"}});
+                    forgetRecoveredLocked(it->first);
+                    it = inFlight.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            inFlight.emplace(op.id, std::move(op));
+        }
+        syncLsn = std::max(syncLsn, lsn);
+        durable.wait(lock, [&] { return durableLsn >= lsn || failed; });
+        if (durableLsn < lsn) {
+            throw std::runtime_error("Journal write failed: " + path);
+        }
+        return ids;
+    }
+
+    void commit(uint64_t id) {
+        end(id, "commit");
+    }
+
+    void abort(uint64_t id) {
+        end(id, "abort");
+    }
+
+    // Waits until every record appended so far is on disk
+    bool sync() {
+        std::unique_lock<std::mutex> lock(mutex);
+        uint64_t lsn = appendedLsn;
+        syncLsn = std::max(syncLsn, lsn);
+        work.notify_one();
+        durable.wait(lock, [&] { return durableLsn >= lsn || failed; });
+        return durableLsn >= lsn;
+    }
+
+    // Operations that had begun but not ended when the journal was opened
+    std::vector<JournalOp> unfinished() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recovered;
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats_;
+    }
+
+private:
+    const std::string path;
+    const size_t compactBytes;
+    const std::chrono::microseconds syncWindow;
+    int fd = -1;
+    size_t fileBytes = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable work;
+    std::condition_variable durable;
+    std::string buffer;                      // Records appended but not yet written
+    uint64_t appendedLsn = 0;                // Sequence number of the last appended record
+    uint64_t durableLsn = 0;                 // Last record known to be on disk
+    uint64_t syncLsn = 0;                    // Last record a caller is waiting to be durable
+    uint64_t nextId = 1;
+    std::map<uint64_t, JournalOp> inFlight;  // Begun and not yet ended, by id
+    std::vector<JournalOp> recovered;
+    Stats stats_;
+    bool failed = false;
+    bool stopping = false;
+    std::thread flusher;
+
+    // FNV-1a over the record text; enough to catch a torn or garbled line
+    static uint32_t checksum(const std::string& text) {
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : text) {
+            hash = (hash ^ c) * 16777619u;
+        }
+        return hash;
+    }
+
+    static std::string encode(const json& record) {
+        std::string text = record.dump();
+        char prefix[16];
+        std::snprintf(prefix, sizeof(prefix), "%08x ", checksum(text));
+        return prefix + text + "\n";
+    }
+
+    uint64_t appendLocked(const json& record) {
+        buffer += encode(record);
+        ++stats_.records;
+        work.notify_one();
+        return ++appendedLsn;
+    }
+
+    void end(uint64_t id, const char* outcome) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!inFlight.erase(id)) {
+            return;
+        }
+        forgetRecoveredLocked(id);
+        appendLocked({{"id", id}, {"record", outcome}});
+    }
+
+    void forgetRecoveredLocked(uint64_t id) {
+        recovered.erase(std::remove_if(recovered.begin(), recovered.end(),
+                                       [id](const JournalOp& op) { return op.id == id; }),
+                        recovered.end());
+    }
+
+    // Loads the existing file and returns how many leading bytes are valid
+    size_t replay() {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return 0;
+        }
+        size_t validBytes = 0;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (file.eof() || line.size() < 10 || line[8] != ' ') {
+                break;  // No trailing newline, or too short: torn write
+            }
+            std::string text = line.substr(9);
+            if (std::strtoul(line.substr(0, 8).c_str(), nullptr, 16) != checksum(text)) {
+                LOG_WARN("Journal ", path, ": checksum mismatch at byte ", validBytes, ", ignoring the rest");
+                break;
+            }
+            json record = json::parse(text, nullptr, false);
+            if (record.is_discarded()) {
+                break;
+            }
+            validBytes += line.size() + 1;
+
+            uint64_t id = record.value("id", uint64_t(0));
+            nextId = std::max(nextId, id + 1);
+            if (record.value("record", "") == "begin") {
+                JournalOp op;
+                op.id = id;
+                op.kind = record.value("kind", "");
+                op.uniqueId = record.value("uniqueId", "");
+                op.fromNamespace = record.value("fromNamespace", "");
+                op.manifest = record.value("manifest", json::object());
+                inFlight[id] = std::move(op);
+            } else {
+                inFlight.erase(id);
+            }
+        }
+        for (const auto& entry : inFlight) {
+            recovered.push_back(entry.second);
+        }
+        if (!recovered.empty()) {
+            LOG_WARN("Journal ", path, ": ", recovered.size(), " unfinished operation(s) to resume");
+        }
+        return validBytes;
+    }
+
+    void flushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            work.wait(lock, [this] { return stopping || !buffer.empty(); });
+            if (buffer.empty()) {
+                return;  // Stopping with nothing left to write
+            }
+            work.wait_for(lock, syncWindow, [this] { return stopping; });
+
+            // Everything that arrives while this batch is being written goes in the next one
+            std::string batch;
+            batch.swap(buffer);
+            uint64_t batchLsn = appendedLsn;
+            bool needsSync = stopping || syncLsn > durableLsn;
+            lock.unlock();
+            bool written = writeAll(batch) && (!needsSync || ::fdatasync(fd) == 0);
+            lock.lock();
+
+            if (!written) {
+                LOG_ERROR("Journal ", path, " write failed: ", std::strerror(errno));
+                failed = true;
+                durable.notify_all();
+                continue;
+            }
+            fileBytes += batch.size();
+            if (needsSync) {
+                durableLsn = batchLsn;
+                ++stats_.syncs;
+                durable.notify_all();
+            }
+
+            // Nothing in flight and nothing buffered: every record in the file
+            // is resolved, so it can start over. The truncate is synced, so
+            // unsynced end records before it don't matter.
+            if (inFlight.empty() && buffer.empty() && fileBytes >= compactBytes) {
+                if (::ftruncate(fd, 0) == 0 && ::fdatasync(fd) == 0) {
+                    fileBytes = 0;
+                }
+            }
+        }
+    }
+
+    bool writeAll(const std::string& data) {
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t written = ::write(fd, data.data() + offset, data.size() - offset);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            offset += written;
+        }
+        return true;
+    }
+};
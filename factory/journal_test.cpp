@@ -0,0 +1,140 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "journal.h"
+#include "test_check.h"
+
+JournalOp moveOp(const std::string& uniqueId) {
+    JournalOp op;
+    op.kind = "move";
+    op.uniqueId = uniqueId;
+    op.fromNamespace = "default-namespace";
+    op.manifest = {{"metadata", {{"name", "common-pod-" + uniqueId}, {"namespace", "privileged-namespace"}}}};
+    return op;
+}
+
+int main() {
+    const std::string path = "journal_test.journal";
+    std::remove(path.c_str());
+
+    // A crash between begin and commit leaves the operation for the next open
+    uint64_t doneId = 0;
+    uint64_t pendingId = 0;
+    {
+        Journal journal(path);
+        check(journal.unfinished().empty(), "new journal has nothing to resume");
+        doneId = journal.begin(moveOp("1"));
+        pendingId = journal.begin(moveOp("2"));
+        journal.commit(doneId);
+        check(journal.sync(), "sync succeeds");
+    }
+    {
+        Journal journal(path);
+        auto pending = journal.unfinished();
+        check(pending.size() == 1, "one operation left unfinished");
+        if (pending.size() == 1) {
+            check(pending[0].id == pendingId && pending[0].uniqueId == "2", "unfinished op is the uncommitted one");
+            check(pending[0].manifest["metadata"]["namespace"] == "privileged-namespace", "manifest survives replay");
+        }
+        check(journal.begin(moveOp("3")) > pendingId, "ids keep increasing across restarts");
+        journal.abort(pendingId);
+        check(journal.unfinished().empty(), "abort resolves a recovered operation");
+    }
+
+    // A torn final record is dropped rather than failing the open
+    {
+        std::ofstream file(path, std::ios::app | std::ios::binary);
+        file << "0badf00d {\"id\":99,\"record\":\"be";
+    }
+    {
+        Journal journal(path);
+        auto pending = journal.unfinished();
+        check(pending.size() == 1 && pending[0].uniqueId == "3", "torn tail ignored, earlier records kept");
+        journal.commit(pending.empty() ? 0 : pending[0].id);
+    }
+
+    // A newer operation on the same pod replaces the older unfinished one
+    uint64_t latestId = 0;
+    {
+        Journal journal(path);
+        journal.begin(moveOp("4"));
+        latestId = journal.begin(moveOp("4"));
+    }
+    {
+        Journal journal(path);
+        auto pending = journal.unfinished();
+        check(pending.size() == 1 && pending[0].id == latestId, "only the latest operation per pod is resumed");
+        journal.commit(latestId);
+    }
+
+    // A create whose createPod failed stays open; removing the pod afterwards
+    // must close it, or the next start would recreate a pod the user removed
+    {
+        Journal journal(path);
+        JournalOp create = moveOp("5");
+        create.kind = "create";
+        create.fromNamespace = "";
+        journal.begin(create);
+        journal.commit(journal.begin(JournalOp{0, "delete", "5", "", json::object()}));
+    }
+    {
+        Journal journal(path);
+        check(journal.unfinished().empty(), "a committed delete supersedes the failed create");
+    }
+
+    // Concurrent writers share disk syncs
+    {
+        std::remove(path.c_str());
+        Journal journal(path, 0);
+        const int threads = 8;
+        const int opsPerThread = 200;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&journal, t] {
+                for (int i = 0; i < opsPerThread; ++i) {
+                    uint64_t id = journal.begin(moveOp(std::to_string(t * opsPerThread + i)));
+                    journal.commit(id);
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        journal.sync();
+        Journal::Stats stats = journal.stats();
+        std::cout << stats.records << " records in " << stats.syncs << " syncs" << std::endl;
+        check(stats.records == 2u * threads * opsPerThread, "every begin and commit recorded");
+        check(stats.syncs < stats.records, "group commit batches records into fewer syncs");
+    }
+    {
+        // compactBytes = 0 above: with everything committed the file was emptied
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        check(file.tellg() == 0, "fully committed journal is truncated");
+    }
+
+    // Commits don't cost a sync of their own, even with no window to share one
+    {
+        std::remove(path.c_str());
+        Journal journal(path, 1 << 20, std::chrono::microseconds(0));
+        const int ops = 100;
+        for (int i = 0; i < ops; ++i) {
+            journal.commit(journal.begin(moveOp(std::to_string(i))));
+        }
+        Journal::Stats stats = journal.stats();
+        check(stats.syncs <= static_cast<uint64_t>(ops), "commit-only batches are not synced, got " +
+                                                             std::to_string(stats.syncs) + " syncs for " +
+                                                             std::to_string(ops) + " operations");
+    }
+    {
+        Journal journal(path);
+        check(journal.unfinished().empty(), "unsynced commits are still written out on close");
+    }
+
+    std::remove(path.c_str());
+    return testResult();
+}
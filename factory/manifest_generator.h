@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Synthetic pod manifests for benchmarks and load tests. The output is
+// deterministic for a given seed so runs can be diffed against each other.
+struct ManifestOptions {
+    size_t podCount = 100;
+    size_t labelKeys = 4;            // Labels per pod
+    size_t labelCardinality = 16;    // Distinct values per label key
+    size_t annotationBytes = 64;     // Size of the description annotation
+    size_t namespaces = 1;
+    uint32_t seed = 42;
+};
+
+class ManifestGenerator {
+public:
+    explicit ManifestGenerator(const ManifestOptions& options) : options(options), rng(options.seed) {}
+
+    // A single Pod manifest, as the API server would return it
+    std::string pod(size_t index) {
+        return R"({"kind":"Pod",)" + podFields(index);
+    }
+
+    // A PodList of podCount pods, the shape createElementList expects. As from
+    // a real API server, the items carry no kind of their own.
+    std::string podList() {
+        std::string out = R"({"kind":"PodList","apiVersion":"v1","items":[)";
+        for (size_t i = 0; i < options.podCount; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            out += '{';
+            out += podFields(i);
+        }
+        out += "]}";
+        return out;
+    }
+
+private:
+    ManifestOptions options;
+    std::mt19937 rng;
+
+    // Everything after the opening brace of a pod object
+    std::string podFields(size_t index) {
+        std::string out;
+        out.reserve(256 + options.labelKeys * 32 + options.annotationBytes);
+        out += R"("metadata":{"name":"common-pod-)";
+        out += std::to_string(index);
+        out += R"(","namespace":"ns-)";
+        out += std::to_string(index % (options.namespaces == 0 ? 1 : options.namespaces));
+        out += R"(","creationTimestamp":"2023-04-01T12:34:56Z","labels":{"unique-id":")";
+        out += std::to_string(index);
+        out += '"';
+        std::uniform_int_distribution<size_t> value(0, options.labelCardinality == 0 ? 0 : options.labelCardinality - 1);
+        for (size_t key = 0; key < options.labelKeys; ++key) {
+            out += R"(,"label-)";
+            out += std::to_string(key);
+            out += R"(":"value-)";
+            out += std::to_string(value(rng));
+            out += '"';
+        }
+        out += R"(},"annotations":{"description":")";
+        out += annotation();
+        out += R"("}},"spec":{"containers":[{"name":"common-app-)";
+        out += std::to_string(index);
+        out += R"(","image":"nginx:1.25"}]}})";
+        return out;
+    }
+
+    std::string annotation() {
+        static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789 ";
+        std::uniform_int_distribution<size_t> letter(0, sizeof(alphabet) - 2);
+        std::string text(options.annotationBytes, ' ');
+        for (char& c : text) {
+            c = alphabet[letter(rng)];
+        }
+        return text;
+    }
+};
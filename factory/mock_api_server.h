@@ -0,0 +1,310 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Minimal in-process stand-in for a Kubernetes API server, for tests and
+// benchmarks. Speaks plain HTTP/1.1 with keep-alive on 127.0.0.1 and serves
+// just the endpoints this project uses: list namespaces, list pods (per
+// namespace or cluster-wide), create pod, delete pod. Bodies are kept as raw
+// JSON strings so the server has no parsing dependency; label selectors are
+// ignored. Lists are typed (PodList, NamespaceList) and, like a real server,
+// their items carry no "kind". An optional per-request delay simulates a slow
+// cluster.
+class MockApiServer {
+public:
+    explicit MockApiServer(std::chrono::milliseconds latency = std::chrono::milliseconds(0)) : latency(latency) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listenFd < 0) {
+            throw std::runtime_error("MockApiServer: socket() failed");
+        }
+        int reuse = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;  // Let the kernel pick a free port
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd, 128) < 0) {
+            close(listenFd);
+            throw std::runtime_error("MockApiServer: bind/listen failed");
+        }
+        socklen_t length = sizeof(addr);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+        port = ntohs(addr.sin_port);
+
+        acceptThread = std::thread([this] { acceptLoop(); });
+    }
+
+    ~MockApiServer() {
+        running.store(false);
+        shutdown(listenFd, SHUT_RDWR);
+        close(listenFd);
+        if (acceptThread.joinable()) {
+            acceptThread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            for (int fd : connectionFds) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (auto& thread : connectionThreads) {
+            thread.join();
+        }
+    }
+
+    MockApiServer(const MockApiServer&) = delete;
+    MockApiServer& operator=(const MockApiServer&) = delete;
+
+    std::string url() const {
+        return "http://127.0.0.1:" + std::to_string(port);
+    }
+
+    void addNamespace(const std::string& name) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pods[name];
+    }
+
+    // Stores a pod manifest under namespace/name
+    void addPod(const std::string& namespaceName, const std::string& name, const std::string& podJson) {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pods[namespaceName][name] = podJson;
+    }
+
+    size_t podCount() const {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        size_t count = 0;
+        for (const auto& ns : pods) {
+            count += ns.second.size();
+        }
+        return count;
+    }
+
+    uint64_t requestCount() const {
+        return requests.load();
+    }
+
+private:
+    std::chrono::milliseconds latency;
+    int listenFd = -1;
+    uint16_t port = 0;
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> requests{0};
+    std::thread acceptThread;
+    std::mutex connectionsMutex;
+    std::vector<int> connectionFds;
+    std::vector<std::thread> connectionThreads;
+    mutable std::mutex stateMutex;
+    std::map<std::string, std::map<std::string, std::string>> pods;  // namespace -> name -> manifest
+
+    void acceptLoop() {
+        while (running.load()) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(connectionsMutex);
+            if (!running.load()) {
+                close(fd);
+                break;
+            }
+            connectionFds.push_back(fd);
+            connectionThreads.emplace_back([this, fd] {
+                serveConnection(fd);
+                closeConnection(fd);
+            });
+        }
+    }
+
+    void serveConnection(int fd) {
+        std::string buffer;
+        char chunk[4096];
+        while (running.load()) {
+            std::string::size_type headerEnd;
+            while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    return;
+                }
+                buffer.append(chunk, received);
+            }
+            std::string head = buffer.substr(0, headerEnd);
+            size_t contentLength = 0;
+            std::string::size_type lengthPos = head.find("Content-Length:");
+            if (lengthPos != std::string::npos) {
+                contentLength = std::stoul(head.substr(lengthPos + 15));
+            }
+            while (buffer.size() < headerEnd + 4 + contentLength) {
+                ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+                if (received <= 0) {
+                    return;
+                }
+                buffer.append(chunk, received);
+            }
+            std::string body = buffer.substr(headerEnd + 4, contentLength);
+            buffer.erase(0, headerEnd + 4 + contentLength);
+
+            std::string::size_type methodEnd = head.find(' ');
+            std::string method = head.substr(0, methodEnd);
+            std::string target = head.substr(methodEnd + 1, head.find(' ', methodEnd + 1) - methodEnd - 1);
+            requests.fetch_add(1);
+            if (latency.count() > 0) {
+                std::this_thread::sleep_for(latency);
+            }
+
+            int status = 200;
+            std::string responseBody = handle(method, target.substr(0, target.find('?')), body, status);
+            std::string response = "HTTP/1.1 " + std::to_string(status) + (status < 300 ? " OK" : " Error") +
+                                   "\r\nContent-Type: application/json\r\nContent-Length: " +
+                                   std::to_string(responseBody.size()) + "\r\n\r\n" + responseBody;
+            if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) < 0) {
+                return;
+            }
+        }
+    }
+
+    void closeConnection(int fd) {
+        std::lock_guard<std::mutex> lock(connectionsMutex);
+        connectionFds.erase(std::find(connectionFds.begin(), connectionFds.end(), fd));
+        close(fd);
+    }
+
+    static std::vector<std::string> splitPath(const std::string& path) {
+        std::vector<std::string> segments;
+        std::string::size_type start = 1;
+        while (start <= path.size()) {
+            std::string::size_type end = path.find('/', start);
+            if (end == std::string::npos) {
+                end = path.size();
+            }
+            if (end > start) {
+                segments.push_back(path.substr(start, end - start));
+            }
+            start = end + 1;
+        }
+        return segments;
+    }
+
+    // Pulls metadata.name out of a manifest without a JSON parser
+    static std::string extractName(const std::string& manifest) {
+        std::string::size_type metadata = manifest.find("\"metadata\"");
+        std::string::size_type key = manifest.find("\"name\"", metadata == std::string::npos ? 0 : metadata);
+        if (key == std::string::npos) {
+            return "";
+        }
+        std::string::size_type open = manifest.find('"', manifest.find(':', key) + 1);
+        std::string::size_type close = manifest.find('"', open + 1);
+        return manifest.substr(open + 1, close - open - 1);
+    }
+
+    // Removes the top-level "kind" member of an object, as a real API server
+    // omits it from the items of a typed list
+    static std::string stripKind(const std::string& object) {
+        int depth = 0;
+        bool inString = false;
+        for (size_t i = 0; i < object.size(); ++i) {
+            char c = object[i];
+            if (inString) {
+                if (c == '\\') {
+                    ++i;
+                } else if (c == '"') {
+                    inString = false;
+                }
+                continue;
+            }
+            if (c == '{') {
+                ++depth;
+            } else if (c == '}') {
+                --depth;
+            } else if (c == '"') {
+                if (depth == 1 && object.compare(i, 6, "\"kind\"") == 0) {
+                    size_t valueOpen = object.find('"', object.find(':', i + 6) + 1);
+                    size_t end = object.find('"', valueOpen + 1) + 1;
+                    if (end < object.size() && object[end] == ',') {
+                        ++end;
+                    } else if (i > 0 && object[i - 1] == ',') {
+                        --i;
+                    }
+                    return object.substr(0, i) + object.substr(end);
+                }
+                inString = true;
+            }
+        }
+        return object;
+    }
+
+    static std::string itemList(const std::string& kind, const std::vector<std::string>& items) {
+        std::string list = "{\"kind\":\"" + kind + "\",\"apiVersion\":\"v1\",\"items\":[";
+        for (size_t i = 0; i < items.size(); ++i) {
+            list += (i ? "," : "") + stripKind(items[i]);
+        }
+        return list + "]}";
+    }
+
+    std::string handle(const std::string& method, const std::string& path, const std::string& body, int& status) {
+        std::vector<std::string> segments = splitPath(path);
+        std::lock_guard<std::mutex> lock(stateMutex);
+
+        // /api/v1/namespaces
+        if (segments.size() == 3 && segments[2] == "namespaces" && method == "GET") {
+            std::vector<std::string> items;
+            for (const auto& ns : pods) {
+                items.push_back("{\"metadata\":{\"name\":\"" + ns.first + "\"}}");
+            }
+            return itemList("NamespaceList", items);
+        }
+        // /api/v1/pods
+        if (segments.size() == 3 && segments[2] == "pods" && method == "GET") {
+            std::vector<std::string> items;
+            for (const auto& ns : pods) {
+                for (const auto& pod : ns.second) {
+                    items.push_back(pod.second);
+                }
+            }
+            return itemList("PodList", items);
+        }
+        // /api/v1/namespaces/{ns}/pods[/{name}]
+        if (segments.size() >= 5 && segments[2] == "namespaces" && segments[4] == "pods") {
+            auto& namespacePods = pods[segments[3]];
+            if (segments.size() == 5 && method == "GET") {
+                std::vector<std::string> items;
+                for (const auto& pod : namespacePods) {
+                    items.push_back(pod.second);
+                }
+                return itemList("PodList", items);
+            }
+            if (segments.size() == 5 && method == "POST") {
+                std::string name = extractName(body);
+                if (namespacePods.count(name)) {
+                    status = 409;
+                    return "{\"kind\":\"Status\",\"reason\":\"AlreadyExists\"}";
+                }
+                namespacePods[name] = body;
+                status = 201;
+                return body;
+            }
+            if (segments.size() == 6 && method == "DELETE") {
+                if (namespacePods.erase(segments[5]) == 0) {
+                    status = 404;
+                    return "{\"kind\":\"Status\",\"reason\":\"NotFound\"}";
+                }
+                return "{\"kind\":\"Status\",\"status\":\"Success\"}";
+            }
+        }
+        status = 404;
+        return "{\"kind\":\"Status\",\"reason\":\"NotFound\"}";
+    }
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Function to create a pod manifest by combining pod template and container spec
+inline json createPodManifest(const json& podTemplate, const json& containerSpec) {
+    json podManifest = podTemplate;
+    podManifest["spec"]["containers"].push_back(containerSpec);
+    return podManifest;
+}
+
+inline json createConfiguredComponent(json podSpec, json containerSpec, const std::string& id){
+  json podManifest = podSpec;
+  containerSpec["name"] = "common-app-" + id;
+  podManifest["metadata"]["name"] = "common-pod-" + id;
+  podManifest["metadata"]["labels"]["unique-id"] = id;
+  podManifest["metadata"]["labels"]["app"] = "common-app"; // generic name for content of pod. standardized as common app in this example model 
+  podManifest["spec"]["containers"].push_back(containerSpec);
+  return podManifest;
+}
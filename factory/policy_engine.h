@@ -0,0 +1,789 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Local NetworkPolicy evaluation. Policies are compiled against the known
+// pods into bitsets indexed by pod slot, so connectivity questions become
+// bit tests and reachability rows become word-wide OR/AND passes. Pod,
+// namespace and policy changes update only the bits they affect.
+//
+// Only pod-to-pod traffic is modelled: ipBlock peers are ignored.
+
+// Fixed-width bitset over pod slots. The word loops are written so the
+// compiler can vectorize them.
+class PodSet {
+public:
+    PodSet() = default;
+    explicit PodSet(size_t bits) : words((bits + 63) / 64, 0) {}
+
+    void resize(size_t bits) {
+        words.resize((bits + 63) / 64, 0);
+    }
+
+    size_t wordCount() const {
+        return words.size();
+    }
+
+    void set(size_t bit, bool value = true) {
+        uint64_t mask = uint64_t(1) << (bit & 63);
+        words[bit >> 6] = value ? (words[bit >> 6] | mask) : (words[bit >> 6] & ~mask);
+    }
+
+    bool test(size_t bit) const {
+        return (words[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    PodSet& operator|=(const PodSet& other) {
+        uint64_t* __restrict out = words.data();
+        const uint64_t* __restrict in = other.words.data();
+        for (size_t i = 0, n = words.size(); i < n; ++i) {
+            out[i] |= in[i];
+        }
+        return *this;
+    }
+
+    PodSet& operator&=(const PodSet& other) {
+        uint64_t* __restrict out = words.data();
+        const uint64_t* __restrict in = other.words.data();
+        for (size_t i = 0, n = words.size(); i < n; ++i) {
+            out[i] &= in[i];
+        }
+        return *this;
+    }
+
+    // this &= ~other
+    PodSet& subtract(const PodSet& other) {
+        uint64_t* __restrict out = words.data();
+        const uint64_t* __restrict in = other.words.data();
+        for (size_t i = 0, n = words.size(); i < n; ++i) {
+            out[i] &= ~in[i];
+        }
+        return *this;
+    }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t word : words) {
+            total += __builtin_popcountll(word);
+        }
+        return total;
+    }
+
+    template <typename F>
+    void forEach(F&& visit) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint64_t word = words[i];
+            while (word) {
+                visit(i * 64 + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<uint64_t> words;
+};
+
+using LabelMap = std::unordered_map<std::string, std::string>;
+
+// matchLabels plus matchExpressions (In, NotIn, Exists, DoesNotExist).
+// An empty selector matches everything.
+struct LabelSelector {
+    struct Requirement {
+        std::string key;
+        std::string op;
+        std::vector<std::string> values;
+    };
+
+    std::vector<std::pair<std::string, std::string>> matchLabels;
+    std::vector<Requirement> matchExpressions;
+
+    bool matches(const LabelMap& labels) const {
+        for (const auto& required : matchLabels) {
+            auto found = labels.find(required.first);
+            if (found == labels.end() || found->second != required.second) {
+                return false;
+            }
+        }
+        for (const auto& requirement : matchExpressions) {
+            auto found = labels.find(requirement.key);
+            bool has = found != labels.end();
+            bool inValues = has && std::find(requirement.values.begin(), requirement.values.end(), found->second) != requirement.values.end();
+            if ((requirement.op == "In" && !inValues) || (requirement.op == "NotIn" && inValues) ||
+                (requirement.op == "Exists" && !has) || (requirement.op == "DoesNotExist" && has)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct PolicyPeer {
+    bool hasPodSelector = false;
+    bool hasNamespaceSelector = false;
+    LabelSelector podSelector;
+    LabelSelector namespaceSelector;
+};
+
+struct PolicyPort {
+    std::string protocol = "TCP";
+    int port = 0;     // 0 = all ports (port omitted)
+    int endPort = 0;  // Inclusive range end when set
+    std::string name; // Named port such as "http". Container ports aren't tracked,
+                      // so a named port can't be resolved and matches nothing.
+
+    bool matches(int queryPort, const std::string& queryProtocol) const {
+        if (protocol != queryProtocol || !name.empty()) {
+            return false;
+        }
+        if (port == 0) {
+            return true;
+        }
+        return endPort > 0 ? queryPort >= port && queryPort <= endPort : queryPort == port;
+    }
+};
+
+struct PolicyRule {
+    std::vector<PolicyPeer> peers;  // Empty = all pods
+    std::vector<PolicyPort> ports;  // Empty = all ports
+
+    bool matchesPort(int port, const std::string& protocol) const {
+        if (ports.empty()) {
+            return true;
+        }
+        for (const auto& candidate : ports) {
+            if (candidate.matches(port, protocol)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+struct PolicySpec {
+    std::string name;
+    std::string namespace_;
+    LabelSelector podSelector;
+    bool ingress = true;
+    bool egress = false;
+    std::vector<PolicyRule> ingressRules;
+    std::vector<PolicyRule> egressRules;
+};
+
+inline LabelSelector parseLabelSelector(const json& j) {
+    LabelSelector selector;
+    if (j.contains("matchLabels")) {
+        for (const auto& label : j["matchLabels"].items()) {
+            selector.matchLabels.emplace_back(label.key(), label.value().get<std::string>());
+        }
+    }
+    if (j.contains("matchExpressions")) {
+        for (const auto& expression : j["matchExpressions"]) {
+            LabelSelector::Requirement requirement;
+            requirement.key = expression.value("key", "");
+            requirement.op = expression.value("operator", "");
+            if (expression.contains("values")) {
+                requirement.values = expression["values"].get<std::vector<std::string>>();
+            }
+            selector.matchExpressions.push_back(std::move(requirement));
+        }
+    }
+    return selector;
+}
+
+inline PolicyRule parsePolicyRule(const json& j, const char* peersKey) {
+    PolicyRule rule;
+    if (j.contains(peersKey)) {
+        for (const auto& peerJson : j[peersKey]) {
+            PolicyPeer peer;
+            if (peerJson.contains("podSelector")) {
+                peer.hasPodSelector = true;
+                peer.podSelector = parseLabelSelector(peerJson["podSelector"]);
+            }
+            if (peerJson.contains("namespaceSelector")) {
+                peer.hasNamespaceSelector = true;
+                peer.namespaceSelector = parseLabelSelector(peerJson["namespaceSelector"]);
+            }
+            if (peer.hasPodSelector || peer.hasNamespaceSelector) {
+                rule.peers.push_back(std::move(peer));
+            }
+        }
+        if (rule.peers.empty() && !j[peersKey].empty()) {
+            // Only ipBlock peers: matches no pods. Model with a selector nothing can satisfy.
+            PolicyPeer none;
+            none.hasPodSelector = true;
+            none.podSelector.matchExpressions.push_back({"", "In", {}});
+            rule.peers.push_back(std::move(none));
+        }
+    }
+    if (j.contains("ports")) {
+        for (const auto& portJson : j["ports"]) {
+            PolicyPort port;
+            port.protocol = portJson.value("protocol", "TCP");
+            if (portJson.contains("port") && portJson["port"].is_number_integer()) {
+                port.port = portJson["port"].get<int>();
+            } else if (portJson.contains("port") && portJson["port"].is_string()) {
+                port.name = portJson["port"].get<std::string>();
+            }
+            port.endPort = portJson.value("endPort", 0);
+            rule.ports.push_back(port);
+        }
+    }
+    return rule;
+}
+
+// Converts a NetworkPolicy manifest (as in default-policy.json) into a PolicySpec
+inline PolicySpec parseNetworkPolicy(const json& j) {
+    PolicySpec spec;
+    spec.name = j["metadata"].value("name", "");
+    spec.namespace_ = j["metadata"].value("namespace", "default");
+    const json& specJson = j["spec"];
+    if (specJson.contains("podSelector")) {
+        spec.podSelector = parseLabelSelector(specJson["podSelector"]);
+    }
+    if (specJson.contains("ingress")) {
+        for (const auto& ruleJson : specJson["ingress"]) {
+            spec.ingressRules.push_back(parsePolicyRule(ruleJson, "from"));
+        }
+    }
+    if (specJson.contains("egress")) {
+        for (const auto& ruleJson : specJson["egress"]) {
+            spec.egressRules.push_back(parsePolicyRule(ruleJson, "to"));
+        }
+    }
+    if (specJson.contains("policyTypes")) {
+        std::vector<std::string> types = specJson["policyTypes"].get<std::vector<std::string>>();
+        spec.ingress = std::find(types.begin(), types.end(), "Ingress") != types.end();
+        spec.egress = std::find(types.begin(), types.end(), "Egress") != types.end();
+    } else {
+        spec.ingress = true;
+        spec.egress = !spec.egressRules.empty();
+    }
+    return spec;
+}
+
+// Result of a full reachability query for one port. Pods with the same
+// namespace and labels are indistinguishable to every selector, so rows
+// are stored once per such class.
+struct ReachabilityMatrix {
+    std::vector<uint32_t> classOf;  // Pod slot -> row index; UINT32_MAX for empty slots
+    std::vector<PodSet> rows;       // Destinations each class may send to
+
+    bool allowed(size_t src, size_t dst) const {
+        return src < classOf.size() && classOf[src] != UINT32_MAX && rows[classOf[src]].test(dst);
+    }
+
+    const PodSet& row(size_t src) const {
+        return rows[classOf[src]];
+    }
+};
+
+// Connectivity of one pod before and after a hypothetical move
+struct MoveImpact {
+    std::vector<std::string> lostIngress;   // Pods that could reach it and no longer can
+    std::vector<std::string> gainedIngress;
+    std::vector<std::string> lostEgress;    // Pods it could reach and no longer can
+    std::vector<std::string> gainedEgress;
+
+    bool unchanged() const {
+        return lostIngress.empty() && gainedIngress.empty() && lostEgress.empty() && gainedEgress.empty();
+    }
+};
+
+class PolicyEngine {
+public:
+    // Adds or updates a pod; key is "namespace/name"
+    void upsertPod(const std::string& namespaceName, const std::string& name, const LabelMap& labels) {
+        std::string key = namespaceName + "/" + name;
+        size_t slot;
+        auto found = slotOf.find(key);
+        if (found != slotOf.end()) {
+            slot = found->second;
+        } else {
+            slot = allocateSlot();
+            slotOf[key] = slot;
+        }
+        PodEntry& pod = pods[slot];
+        pod.key = key;
+        pod.namespace_ = namespaceName;
+        pod.labels = labels;
+        pod.live = true;
+        live.set(slot);
+        refreshPod(slot);
+    }
+
+    // Accepts any Element-like object (kind, name, namespace_, labels)
+    template <typename E>
+    void upsertPod(const E& element) {
+        upsertPod(element.namespace_, element.name, LabelMap(element.labels.begin(), element.labels.end()));
+    }
+
+    void removePod(const std::string& namespaceName, const std::string& name) {
+        auto found = slotOf.find(namespaceName + "/" + name);
+        if (found == slotOf.end()) {
+            return;
+        }
+        size_t slot = found->second;
+        slotOf.erase(found);
+        pods[slot] = PodEntry();
+        live.set(slot, false);
+        for (auto& entry : policies) {
+            CompiledPolicy& policy = *entry.second;
+            policy.selected.set(slot, false);
+            for (auto& rule : policy.ingress) rule.peerSet.set(slot, false);
+            for (auto& rule : policy.egress) rule.peerSet.set(slot, false);
+        }
+        freeSlots.push_back(slot);
+        isolationDirty = true;
+    }
+
+    // Namespace labels feed namespaceSelector peers. A namespace without
+    // explicit labels still carries kubernetes.io/metadata.name.
+    void upsertNamespace(const std::string& name, const LabelMap& labels) {
+        LabelMap withName = labels;
+        withName["kubernetes.io/metadata.name"] = name;
+        namespaceLabels[name] = std::move(withName);
+        live.forEach([&](size_t slot) {
+            if (pods[slot].namespace_ == name) {
+                refreshPod(slot);
+            }
+        });
+    }
+
+    void upsertPolicy(const PolicySpec& spec) {
+        auto compiled = std::make_unique<CompiledPolicy>();
+        compiled->spec = spec;
+        compiled->selected = PodSet(capacity);
+        for (const auto& rule : spec.ingressRules) {
+            compiled->ingress.push_back(CompiledRule{rule, PodSet(capacity)});
+        }
+        for (const auto& rule : spec.egressRules) {
+            compiled->egress.push_back(CompiledRule{rule, PodSet(capacity)});
+        }
+        live.forEach([&](size_t slot) { refreshPodInPolicy(*compiled, slot); });
+        policies[spec.namespace_ + "/" + spec.name] = std::move(compiled);
+        isolationDirty = true;
+    }
+
+    void upsertPolicy(const json& manifest) {
+        upsertPolicy(parseNetworkPolicy(manifest));
+    }
+
+    void removePolicy(const std::string& namespaceName, const std::string& name) {
+        policies.erase(namespaceName + "/" + name);
+        isolationDirty = true;
+    }
+
+    bool hasPod(const std::string& key) const {
+        return slotOf.count(key) > 0;
+    }
+
+    size_t slot(const std::string& key) const {
+        return slotOf.at(key);
+    }
+
+    const std::string& podKey(size_t slot) const {
+        return pods[slot].key;
+    }
+
+    size_t podCount() const {
+        return slotOf.size();
+    }
+
+    size_t slotCount() const {
+        return pods.size();
+    }
+
+    // One port per distinct behaviour, for callers that want to check them
+    // all: every port number a rule names, plus for each protocol one port no
+    // rule names, which only rules without ports (all ports) apply to. TCP is
+    // always included, so a cluster whose rules name no ports still gets one.
+    std::set<std::pair<std::string, int>> representativePorts() const {
+        std::map<std::string, std::vector<std::pair<int, int>>> named{{"TCP", {}}};
+        for (const auto& entry : policies) {
+            for (const auto* rules : {&entry.second->ingress, &entry.second->egress}) {
+                for (const auto& rule : *rules) {
+                    for (const auto& port : rule.spec.ports) {
+                        auto& ranges = named[port.protocol];
+                        if (port.port != 0) {
+                            ranges.emplace_back(port.port, std::max(port.port, port.endPort));
+                        }
+                    }
+                }
+            }
+        }
+        std::set<std::pair<std::string, int>> ports;
+        for (auto& entry : named) {
+            std::sort(entry.second.begin(), entry.second.end());
+            int unnamed = 1;
+            for (const auto& range : entry.second) {
+                ports.emplace(entry.first, range.first);
+                if (range.first <= unnamed) {
+                    unnamed = std::max(unnamed, range.second + 1);
+                }
+            }
+            if (unnamed <= 65535) {
+                ports.emplace(entry.first, unnamed);
+            }
+        }
+        return ports;
+    }
+
+    // May src open a connection to dst on port? Both egress from src and
+    // ingress to dst must allow it.
+    bool allowed(const std::string& srcKey, const std::string& dstKey, int port, const std::string& protocol = "TCP") {
+        refreshIsolation();
+        size_t src = slotOf.at(srcKey);
+        size_t dst = slotOf.at(dstKey);
+        return egressAllows(src, dst, port, protocol) && ingressAllows(src, dst, port, protocol);
+    }
+
+    ReachabilityMatrix reachability(int port, const std::string& protocol = "TCP") {
+        refreshIsolation();
+        std::vector<RuleRef> ingressRules;
+        std::vector<RuleRef> egressRules;
+        collectRules(port, protocol, ingressRules, egressRules);
+
+        // Destinations that accept anything: live pods no ingress policy selects
+        PodSet openIngress = live;
+        openIngress.subtract(ingressIsolated);
+
+        ReachabilityMatrix matrix;
+        matrix.classOf.assign(pods.size(), UINT32_MAX);
+        std::map<std::string, uint32_t> classes;
+        live.forEach([&](size_t src) {
+            std::string signature = classSignature(src);
+            auto existing = classes.find(signature);
+            if (existing != classes.end()) {
+                matrix.classOf[src] = existing->second;
+                return;
+            }
+
+            PodSet egress(capacity);
+            if (egressIsolated.test(src)) {
+                for (const auto& rule : egressRules) {
+                    if (rule.first->test(src)) {
+                        egress |= rule.second->peerSet;
+                    }
+                }
+            } else {
+                egress = live;
+            }
+
+            PodSet ingress = openIngress;
+            for (const auto& rule : ingressRules) {
+                if (rule.second->peerSet.test(src)) {
+                    ingress |= *rule.first;
+                }
+            }
+
+            egress &= ingress;
+            uint32_t index = static_cast<uint32_t>(matrix.rows.size());
+            matrix.rows.push_back(std::move(egress));
+            classes.emplace(std::move(signature), index);
+            matrix.classOf[src] = index;
+        });
+        return matrix;
+    }
+
+    // What would change for this pod if it were recreated in targetNamespace?
+    // Evaluated on a temporary copy of the pod, so the engine is unchanged afterwards.
+    MoveImpact simulateMove(const std::string& podKey, const std::string& targetNamespace, int port,
+                            const std::string& protocol = "TCP") {
+        size_t source = slotOf.at(podKey);
+        std::string name = podKey.substr(podKey.find('/') + 1);
+        LabelMap labels = pods[source].labels;
+
+        PodSet beforeOut, beforeIn;
+        connectivityOf(source, port, protocol, beforeOut, beforeIn);
+
+        std::string probeName = name + "~move-probe";
+        upsertPod(targetNamespace, probeName, labels);
+        size_t probe = slotOf.at(targetNamespace + "/" + probeName);
+        PodSet afterOut, afterIn;
+        connectivityOf(probe, port, protocol, afterOut, afterIn);
+        removePod(targetNamespace, probeName);
+
+        // Adding the probe may have grown the bitsets
+        beforeOut.resize(capacity);
+        beforeIn.resize(capacity);
+        // The pod and its probe are the same workload; don't report them to each other
+        for (PodSet* set : {&beforeOut, &beforeIn, &afterOut, &afterIn}) {
+            set->set(source, false);
+            set->set(probe, false);
+        }
+
+        MoveImpact impact;
+        diffInto(beforeIn, afterIn, impact.lostIngress, impact.gainedIngress);
+        diffInto(beforeOut, afterOut, impact.lostEgress, impact.gainedEgress);
+        return impact;
+    }
+
+private:
+    struct PodEntry {
+        std::string key;
+        std::string namespace_;
+        LabelMap labels;
+        bool live = false;
+    };
+
+    struct CompiledRule {
+        PolicyRule spec;
+        PodSet peerSet;  // Pods this rule admits as peers
+    };
+
+    struct CompiledPolicy {
+        PolicySpec spec;
+        PodSet selected;  // Pods the policy applies to
+        std::vector<CompiledRule> ingress;
+        std::vector<CompiledRule> egress;
+    };
+
+    // A rule that applies to a port, with the pods its policy selects
+    using RuleRef = std::pair<const PodSet*, const CompiledRule*>;
+
+    std::vector<PodEntry> pods;
+    std::unordered_map<std::string, size_t> slotOf;
+    std::vector<size_t> freeSlots;
+    size_t capacity = 0;
+    PodSet live;
+    std::unordered_map<std::string, LabelMap> namespaceLabels;
+    std::map<std::string, std::unique_ptr<CompiledPolicy>> policies;
+    PodSet ingressIsolated;  // Pods selected by at least one ingress policy
+    PodSet egressIsolated;
+    bool isolationDirty = true;
+
+    size_t allocateSlot() {
+        if (!freeSlots.empty()) {
+            size_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        size_t slot = pods.size();
+        pods.emplace_back();
+        if (pods.size() > capacity) {
+            // Grow every bitset geometrically so inserts stay amortized O(1)
+            capacity = std::max<size_t>(64, capacity * 2);
+            live.resize(capacity);
+            ingressIsolated.resize(capacity);
+            egressIsolated.resize(capacity);
+            for (auto& entry : policies) {
+                entry.second->selected.resize(capacity);
+                for (auto& rule : entry.second->ingress) rule.peerSet.resize(capacity);
+                for (auto& rule : entry.second->egress) rule.peerSet.resize(capacity);
+            }
+        }
+        return slot;
+    }
+
+    const LabelMap& labelsOfNamespace(const std::string& name) {
+        auto found = namespaceLabels.find(name);
+        if (found == namespaceLabels.end()) {
+            found = namespaceLabels.emplace(name, LabelMap{{"kubernetes.io/metadata.name", name}}).first;
+        }
+        return found->second;
+    }
+
+    bool peerMatches(const PolicyPeer& peer, const std::string& policyNamespace, const PodEntry& pod) {
+        if (peer.hasNamespaceSelector) {
+            if (!peer.namespaceSelector.matches(labelsOfNamespace(pod.namespace_))) {
+                return false;
+            }
+        } else if (pod.namespace_ != policyNamespace) {
+            return false;  // podSelector alone is scoped to the policy's namespace
+        }
+        return !peer.hasPodSelector || peer.podSelector.matches(pod.labels);
+    }
+
+    bool ruleMatches(const PolicyRule& rule, const std::string& policyNamespace, const PodEntry& pod) {
+        if (rule.peers.empty()) {
+            return true;
+        }
+        for (const auto& peer : rule.peers) {
+            if (peerMatches(peer, policyNamespace, pod)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void refreshPodInPolicy(CompiledPolicy& policy, size_t slot) {
+        const PodEntry& pod = pods[slot];
+        const std::string& policyNamespace = policy.spec.namespace_;
+        policy.selected.set(slot, pod.namespace_ == policyNamespace && policy.spec.podSelector.matches(pod.labels));
+        for (auto& rule : policy.ingress) {
+            rule.peerSet.set(slot, ruleMatches(rule.spec, policyNamespace, pod));
+        }
+        for (auto& rule : policy.egress) {
+            rule.peerSet.set(slot, ruleMatches(rule.spec, policyNamespace, pod));
+        }
+    }
+
+    void refreshPod(size_t slot) {
+        for (auto& entry : policies) {
+            refreshPodInPolicy(*entry.second, slot);
+        }
+        isolationDirty = true;
+    }
+
+    void refreshIsolation() {
+        if (!isolationDirty) {
+            return;
+        }
+        ingressIsolated = PodSet(capacity);
+        egressIsolated = PodSet(capacity);
+        for (const auto& entry : policies) {
+            if (entry.second->spec.ingress) ingressIsolated |= entry.second->selected;
+            if (entry.second->spec.egress) egressIsolated |= entry.second->selected;
+        }
+        isolationDirty = false;
+    }
+
+    bool egressAllows(size_t src, size_t dst, int port, const std::string& protocol) const {
+        if (!egressIsolated.test(src)) {
+            return true;
+        }
+        for (const auto& entry : policies) {
+            const CompiledPolicy& policy = *entry.second;
+            if (!policy.spec.egress || !policy.selected.test(src)) {
+                continue;
+            }
+            for (const auto& rule : policy.egress) {
+                if (rule.peerSet.test(dst) && rule.spec.matchesPort(port, protocol)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool ingressAllows(size_t src, size_t dst, int port, const std::string& protocol) const {
+        if (!ingressIsolated.test(dst)) {
+            return true;
+        }
+        for (const auto& entry : policies) {
+            const CompiledPolicy& policy = *entry.second;
+            if (!policy.spec.ingress || !policy.selected.test(dst)) {
+                continue;
+            }
+            for (const auto& rule : policy.ingress) {
+                if (rule.peerSet.test(src) && rule.spec.matchesPort(port, protocol)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Enforced rules that apply to port, from policies of the matching type
+    void collectRules(int port, const std::string& protocol, std::vector<RuleRef>& ingressRules,
+                      std::vector<RuleRef>& egressRules) const {
+        for (const auto& entry : policies) {
+            const CompiledPolicy& policy = *entry.second;
+            if (policy.spec.ingress) {
+                for (const auto& rule : policy.ingress) {
+                    if (rule.spec.matchesPort(port, protocol)) {
+                        ingressRules.emplace_back(&policy.selected, &rule);
+                    }
+                }
+            }
+            if (policy.spec.egress) {
+                for (const auto& rule : policy.egress) {
+                    if (rule.spec.matchesPort(port, protocol)) {
+                        egressRules.emplace_back(&policy.selected, &rule);
+                    }
+                }
+            }
+        }
+    }
+
+    // Outbound row and inbound column of one pod, built from the compiled
+    // bitsets the same way as a reachability() row, so the cost is
+    // O(rules x words) rather than a per-pod walk over every policy
+    void connectivityOf(size_t pod, int port, const std::string& protocol, PodSet& outbound, PodSet& inbound) {
+        refreshIsolation();
+        std::vector<RuleRef> ingressRules;
+        std::vector<RuleRef> egressRules;
+        collectRules(port, protocol, ingressRules, egressRules);
+
+        // Row: where pod's egress allows it to go, intersected with the
+        // destinations whose ingress admits pod
+        if (egressIsolated.test(pod)) {
+            outbound = PodSet(capacity);
+            for (const auto& rule : egressRules) {
+                if (rule.first->test(pod)) {
+                    outbound |= rule.second->peerSet;
+                }
+            }
+        } else {
+            outbound = live;
+        }
+        PodSet admitting = live;
+        admitting.subtract(ingressIsolated);
+        for (const auto& rule : ingressRules) {
+            if (rule.second->peerSet.test(pod)) {
+                admitting |= *rule.first;
+            }
+        }
+        outbound &= admitting;
+
+        // Column: sources pod's ingress admits, intersected with the sources
+        // whose egress allows them to reach pod
+        if (ingressIsolated.test(pod)) {
+            inbound = PodSet(capacity);
+            for (const auto& rule : ingressRules) {
+                if (rule.first->test(pod)) {
+                    inbound |= rule.second->peerSet;
+                }
+            }
+        } else {
+            inbound = live;
+        }
+        PodSet sending = live;
+        sending.subtract(egressIsolated);
+        for (const auto& rule : egressRules) {
+            if (rule.second->peerSet.test(pod)) {
+                sending |= *rule.first;
+            }
+        }
+        inbound &= sending;
+    }
+
+    void diffInto(const PodSet& before, const PodSet& after, std::vector<std::string>& lost, std::vector<std::string>& gained) const {
+        PodSet removed = before;
+        removed.subtract(after);
+        PodSet added = after;
+        added.subtract(before);
+        removed.forEach([&](size_t slot) { lost.push_back(pods[slot].key); });
+        added.forEach([&](size_t slot) { gained.push_back(pods[slot].key); });
+    }
+
+    std::string classSignature(size_t slot) const {
+        const PodEntry& pod = pods[slot];
+        std::vector<std::pair<std::string, std::string>> sorted(pod.labels.begin(), pod.labels.end());
+        std::sort(sorted.begin(), sorted.end());
+        std::string signature = pod.namespace_;
+        for (const auto& label : sorted) {
+            signature += '\0';
+            signature += label.first;
+            signature += '=';
+            signature += label.second;
+        }
+        return signature;
+    }
+};
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+#include "policy_engine.h"
+#include "test_check.h"
+
+// Mirrors default-policy.json: pods in default-namespace only talk to pods
+// labelled access=allowed, on TCP 8080.
+PolicySpec defaultNamespacePolicy() {
+    PolicyRule rule;
+    PolicyPeer peer;
+    peer.hasPodSelector = true;
+    peer.podSelector.matchLabels = {{"access", "allowed"}};
+    rule.peers.push_back(peer);
+    rule.ports.push_back(PolicyPort{"TCP", 8080, 0, ""});
+
+    PolicySpec spec;
+    spec.name = "default-namespace-policy";
+    spec.namespace_ = "default-namespace";
+    spec.ingress = true;
+    spec.egress = true;
+    spec.ingressRules.push_back(rule);
+    spec.egressRules.push_back(rule);
+    return spec;
+}
+
+// simulateMove computed the slow way: pairwise allowed() before, then with a
+// real copy of the pod in the target namespace
+MoveImpact bruteForceMove(PolicyEngine& engine, const std::vector<std::string>& keys, const std::string& podKey,
+                          const std::string& targetNamespace, const LabelMap& labels, int port) {
+    std::string moved = targetNamespace + "/copy";
+    auto peers = [&](const std::string& self, bool outbound) {
+        std::set<std::string> result;
+        for (const auto& other : keys) {
+            if (other != podKey && (outbound ? engine.allowed(self, other, port) : engine.allowed(other, self, port))) {
+                result.insert(other);
+            }
+        }
+        return result;
+    };
+    std::set<std::string> beforeOut = peers(podKey, true), beforeIn = peers(podKey, false);
+    engine.upsertPod(targetNamespace, "copy", labels);
+    std::set<std::string> afterOut = peers(moved, true), afterIn = peers(moved, false);
+    engine.removePod(targetNamespace, "copy");
+
+    auto minus = [](const std::set<std::string>& a, const std::set<std::string>& b) {
+        std::vector<std::string> result;
+        std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+        return result;
+    };
+    MoveImpact impact;
+    impact.lostIngress = minus(beforeIn, afterIn);
+    impact.gainedIngress = minus(afterIn, beforeIn);
+    impact.lostEgress = minus(beforeOut, afterOut);
+    impact.gainedEgress = minus(afterOut, beforeOut);
+    return impact;
+}
+
+std::vector<std::string> sorted(std::vector<std::string> keys) {
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+int main() {
+    PolicyEngine engine;
+    engine.upsertPod("default-namespace", "a", {{"app", "common-app"}, {"access", "allowed"}});
+    engine.upsertPod("default-namespace", "b", {{"app", "common-app"}, {"access", "allowed"}});
+    engine.upsertPod("default-namespace", "c", {{"app", "common-app"}});
+    engine.upsertPod("privileged-namespace", "p", {{"app", "common-app"}, {"access", "allowed"}});
+
+    // No policies yet: everything is open
+    check(engine.allowed("default-namespace/a", "default-namespace/c", 9999), "open before policies");
+
+    engine.upsertPolicy(defaultNamespacePolicy());
+    check(engine.allowed("default-namespace/a", "default-namespace/b", 8080), "a -> b on 8080");
+    check(!engine.allowed("default-namespace/a", "default-namespace/b", 9090), "a -> b on 9090 denied");
+    check(!engine.allowed("default-namespace/a", "default-namespace/c", 8080), "a -> c denied, c lacks access label");
+    check(!engine.allowed("default-namespace/c", "default-namespace/a", 8080), "c -> a denied");
+    check(!engine.allowed("default-namespace/a", "privileged-namespace/p", 8080), "podSelector peers stay in the policy namespace");
+    check(engine.allowed("privileged-namespace/p", "privileged-namespace/p", 1), "unselected namespace stays open");
+
+    // Relabelling c updates its bits in place
+    engine.upsertPod("default-namespace", "c", {{"app", "common-app"}, {"access", "allowed"}});
+    check(engine.allowed("default-namespace/a", "default-namespace/c", 8080), "a -> c after relabel");
+
+    ReachabilityMatrix matrix = engine.reachability(8080);
+    size_t a = engine.slot("default-namespace/a");
+    size_t p = engine.slot("privileged-namespace/p");
+    check(matrix.allowed(a, engine.slot("default-namespace/c")), "matrix a -> c");
+    check(!matrix.allowed(a, p), "matrix a -> p denied");
+    check(matrix.rows.size() == 2, "identical pods share a matrix row");
+
+    MoveImpact impact = engine.simulateMove("default-namespace/a", "privileged-namespace", 8080);
+    check(!impact.lostEgress.empty() && !impact.gainedEgress.empty(), "moving a changes who it reaches");
+    check(engine.podCount() == 4, "simulateMove leaves the engine unchanged");
+
+    // Matrix agrees with point queries across the board
+    engine.removePod("default-namespace", "b");
+    matrix = engine.reachability(8080);
+    for (const char* src : {"default-namespace/a", "default-namespace/c", "privileged-namespace/p"}) {
+        for (const char* dst : {"default-namespace/a", "default-namespace/c", "privileged-namespace/p"}) {
+            check(matrix.allowed(engine.slot(src), engine.slot(dst)) == engine.allowed(src, dst, 8080),
+                  std::string("matrix matches allowed() for ") + src + " -> " + dst);
+        }
+    }
+
+    // A named port can't be resolved without container ports; it must not widen to every port
+    PolicyEngine named;
+    named.upsertPod("web", "frontend", {{"app", "frontend"}});
+    named.upsertPod("web", "backend", {{"app", "backend"}});
+    named.upsertPolicy(json::parse(R"({"metadata":{"name":"named-port","namespace":"web"},
+        "spec":{"podSelector":{"matchLabels":{"app":"backend"}},"policyTypes":["Ingress"],
+        "ingress":[{"from":[{"podSelector":{}}],"ports":[{"protocol":"TCP","port":"http"}]}]}})"));
+    check(!named.allowed("web/frontend", "web/backend", 9999), "named port does not allow arbitrary ports");
+    check(!named.allowed("web/frontend", "web/backend", 80), "named port matches nothing");
+
+    // Representative ports: each numbered port, plus one no rule names
+    std::set<std::pair<std::string, int>> expectedPorts{{"TCP", 1}, {"TCP", 8080}};
+    check(engine.representativePorts() == expectedPorts, "8080 and one unnamed port are representative");
+
+    // Rules without ports apply to every port; a move check must still see them
+    PolicyEngine allPorts;
+    allPorts.upsertPod("web", "a", {{"app", "a"}});
+    allPorts.upsertPod("web", "b", {{"app", "b"}});
+    allPorts.upsertPolicy(json::parse(R"({"metadata":{"name":"same-namespace","namespace":"web"},
+        "spec":{"podSelector":{},"policyTypes":["Ingress","Egress"],
+        "ingress":[{"from":[{"podSelector":{}}]}],"egress":[{"to":[{"podSelector":{}}]}]}})"));
+    bool lostPeer = false;
+    for (const auto& port : allPorts.representativePorts()) {
+        lostPeer = lostPeer || !allPorts.simulateMove("web/a", "other", port.second, port.first).lostEgress.empty();
+    }
+    check(!allPorts.representativePorts().empty() && lostPeer, "a policy without ports still flags a lost peer");
+
+    // The bitset move check agrees with pairwise allowed() on a mixed cluster
+    {
+        PolicyEngine mixed;
+        std::vector<std::string> keys;
+        std::vector<LabelMap> labels;
+        for (int i = 0; i < 120; ++i) {
+            LabelMap podLabels{{"app", "app-" + std::to_string(i % 7)}, {"tier", std::to_string(i % 3)}};
+            std::string ns = "ns-" + std::to_string(i % 4);
+            mixed.upsertPod(ns, "pod-" + std::to_string(i), podLabels);
+            keys.push_back(ns + "/pod-" + std::to_string(i));
+            labels.push_back(podLabels);
+        }
+        mixed.upsertNamespace("ns-1", {{"team", "blue"}});
+        for (int i = 0; i < 12; ++i) {
+            PolicySpec spec;
+            spec.name = "policy-" + std::to_string(i);
+            spec.namespace_ = "ns-" + std::to_string(i % 4);
+            spec.podSelector.matchLabels = {{"app", "app-" + std::to_string(i % 7)}};
+            spec.egress = i % 3 != 0;
+            PolicyRule rule;
+            PolicyPeer peer;
+            peer.hasPodSelector = true;
+            peer.podSelector.matchLabels = {{"tier", std::to_string(i % 3)}};
+            if (i % 2 == 0) {
+                peer.hasNamespaceSelector = true;
+                peer.namespaceSelector.matchLabels = {{"team", "blue"}};
+            }
+            rule.peers.push_back(peer);
+            if (i % 4 != 3) {
+                rule.ports.push_back(PolicyPort{"TCP", 8000 + i % 3, 0, ""});
+            }
+            spec.ingressRules.push_back(rule);
+            if (spec.egress) {
+                spec.egressRules.push_back(rule);
+            }
+            mixed.upsertPolicy(spec);
+        }
+        for (int i : {0, 5, 13, 42, 77}) {
+            for (const auto& port : mixed.representativePorts()) {
+                for (const char* target : {"ns-1", "ns-3", "fresh"}) {
+                    MoveImpact fast = mixed.simulateMove(keys[i], target, port.second);
+                    MoveImpact slow = bruteForceMove(mixed, keys, keys[i], target, labels[i], port.second);
+                    check(sorted(fast.lostIngress) == slow.lostIngress && sorted(fast.gainedIngress) == slow.gainedIngress &&
+                              sorted(fast.lostEgress) == slow.lostEgress && sorted(fast.gainedEgress) == slow.gainedEgress,
+                          "simulateMove matches allowed() for " + keys[i] + " -> " + target + " on " +
+                              std::to_string(port.second));
+                }
+            }
+        }
+    }
+
+    // Scale: 10k pods x 500 policies
+    PolicyEngine large;
+    const int podCount = 10000;
+    const int policyCount = 500;
+    const int namespaceCount = 50;
+    for (int i = 0; i < podCount; ++i) {
+        large.upsertPod("ns-" + std::to_string(i % namespaceCount), "pod-" + std::to_string(i),
+                        {{"app", "app-" + std::to_string(i % 200)}, {"tier", std::to_string(i % 3)}});
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < policyCount; ++i) {
+        PolicySpec spec;
+        spec.name = "policy-" + std::to_string(i);
+        spec.namespace_ = "ns-" + std::to_string(i % namespaceCount);
+        spec.podSelector.matchLabels = {{"app", "app-" + std::to_string(i % 200)}};
+        spec.egress = i % 2 == 0;
+        PolicyRule rule;
+        PolicyPeer peer;
+        peer.hasPodSelector = true;
+        peer.hasNamespaceSelector = true;
+        peer.podSelector.matchLabels = {{"tier", std::to_string(i % 3)}};
+        rule.peers.push_back(peer);
+        rule.ports.push_back(PolicyPort{"TCP", 8000 + i % 10, 0, ""});
+        spec.ingressRules.push_back(rule);
+        if (spec.egress) {
+            spec.egressRules.push_back(rule);
+        }
+        large.upsertPolicy(spec);
+    }
+    auto compiled = std::chrono::steady_clock::now();
+    ReachabilityMatrix largeMatrix = large.reachability(8000);
+    auto done = std::chrono::steady_clock::now();
+    large.upsertPod("ns-0", "pod-0", {{"app", "app-1"}, {"tier", "2"}});
+    auto relabelled = std::chrono::steady_clock::now();
+    // What ConnectivityGuard::checkMove does: one simulateMove per representative port
+    size_t lost = 0;
+    for (const auto& port : large.representativePorts()) {
+        MoveImpact moved = large.simulateMove("ns-1/pod-1", "ns-2", port.second, port.first);
+        lost += moved.lostIngress.size() + moved.lostEgress.size();
+    }
+    auto checked = std::chrono::steady_clock::now();
+
+    auto millis = [](auto from, auto to) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+    };
+    auto micros = [](auto from, auto to) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    };
+    std::cout << podCount << " pods x " << policyCount << " policies: compile " << millis(start, compiled)
+              << "ms, reachability " << millis(compiled, done) << "ms (" << largeMatrix.rows.size()
+              << " distinct rows), relabel one pod " << micros(done, relabelled) << "us, move check over "
+              << large.representativePorts().size() << " ports " << millis(relabelled, checked) << "ms" << std::endl;
+    check(largeMatrix.classOf.size() == static_cast<size_t>(podCount), "large matrix covers every pod");
+    check(millis(relabelled, checked) < 500, "move check stays on the bitset path (scalar walk took ~2s)");
+
+    return testResult();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+// Assertions shared by the *_test.cpp executables. A failed check is reported
+// and counted, and the test keeps going so one run shows every failure.
+inline int failures = 0;
+
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << std::endl;
+        ++failures;
+    }
+}
+
+// Prints the verdict and returns main()'s exit code
+inline int testResult() {
+    std::cout << (failures == 0 ? "PASS" : "FAIL") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "api_metrics.h"
+#include "async_logger.h"
+
+// Controller work queue keyed by object (namespace/name or unique-id).
+//  - A key added while already queued is collapsed into the queued entry.
+//  - A key is handed to at most one worker at a time; adds that arrive while
+//    it is being processed are held and requeued when the worker calls done().
+//  - Failed keys come back after an exponential backoff with jitter.
+// Reconcilers should be level-based (read the latest desired state for the
+// key) since many adds may fold into a single get().
+class WorkQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    WorkQueue(std::chrono::milliseconds baseDelay = std::chrono::milliseconds(5),
+              std::chrono::milliseconds maxDelay = std::chrono::milliseconds(30000))
+        : baseDelay(baseDelay), maxDelay(maxDelay), rng(std::random_device{}()) {}
+
+    void add(const std::string& key) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!addLocked(key)) {
+                return;
+            }
+        }
+        ready.notify_one();
+    }
+
+    void addAfter(const std::string& key, std::chrono::milliseconds delay) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (shuttingDown) {
+                return;
+            }
+            delayed.push(DelayedKey{Clock::now() + delay, key});
+        }
+        // Wake a waiter so it re-arms its timeout for the new earliest deadline
+        ready.notify_one();
+    }
+
+    // Requeues after base * 2^(failures-1), capped at maxDelay, then drawn
+    // uniformly from [delay/2, delay] so keys that failed together don't retry
+    // together.
+    void addRateLimited(const std::string& key) {
+        std::chrono::milliseconds delay;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            int attempt = ++failures[key];
+            double backoff = baseDelay.count() * std::pow(2.0, std::min(attempt - 1, 30));
+            double capped = std::min(backoff, static_cast<double>(maxDelay.count()));
+            std::uniform_real_distribution<double> jitter(capped / 2, capped);
+            delay = std::chrono::milliseconds(static_cast<int64_t>(jitter(rng)));
+            ++retryCount;
+        }
+        addAfter(key, delay);
+    }
+
+    // Clears the failure history of key, resetting its backoff
+    void forget(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failures.erase(key);
+    }
+
+    int numRequeues(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = failures.find(key);
+        return found == failures.end() ? 0 : found->second;
+    }
+
+    // Blocks until a key is ready. Returns false once the queue is shut down.
+    bool get(std::string& key) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            promoteDueLocked();
+            if (!queue.empty()) {
+                break;
+            }
+            if (shuttingDown) {
+                return false;
+            }
+            if (delayed.empty()) {
+                ready.wait(lock);
+            } else {
+                ready.wait_until(lock, delayed.top().due);
+            }
+        }
+        key = std::move(queue.front());
+        queue.pop_front();
+        dirty.erase(key);
+        processing.insert(key);
+        return true;
+    }
+
+    // Must be called once for every successful get()
+    void done(const std::string& key) {
+        bool requeued = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            processing.erase(key);
+            if (dirty.count(key)) {
+                queue.push_back(key);
+                requeued = true;
+            }
+        }
+        if (requeued) {
+            ready.notify_one();
+        }
+    }
+
+    void shutDown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shuttingDown = true;
+        }
+        ready.notify_all();
+    }
+
+    size_t length() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.size();
+    }
+
+    uint64_t retries() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return retryCount;
+    }
+
+private:
+    struct DelayedKey {
+        Clock::time_point due;
+        std::string key;
+        bool operator>(const DelayedKey& other) const {
+            return due > other.due;
+        }
+    };
+
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::string> queue;
+    std::unordered_set<std::string> dirty;       // Queued or waiting for its worker to finish
+    std::unordered_set<std::string> processing;  // Currently held by a worker
+    std::priority_queue<DelayedKey, std::vector<DelayedKey>, std::greater<DelayedKey>> delayed;
+    std::unordered_map<std::string, int> failures;
+    std::chrono::milliseconds baseDelay;
+    std::chrono::milliseconds maxDelay;
+    std::mt19937 rng;
+    uint64_t retryCount = 0;
+    bool shuttingDown = false;
+
+    // Returns true if the key was pushed onto the ready queue
+    bool addLocked(const std::string& key) {
+        if (shuttingDown || dirty.count(key)) {
+            return false;
+        }
+        dirty.insert(key);
+        if (processing.count(key)) {
+            return false;  // done() will requeue it
+        }
+        queue.push_back(key);
+        return true;
+    }
+
+    void promoteDueLocked() {
+        auto now = Clock::now();
+        while (!delayed.empty() && delayed.top().due <= now) {
+            addLocked(delayed.top().key);
+            delayed.pop();
+        }
+    }
+};
+
+// Runs a fixed set of workers over a WorkQueue. The reconcile function
+// returns true on success; on false (or an exception) the key is retried
+// with backoff.
+class Reconciler {
+public:
+    using ReconcileFunc = std::function<bool(const std::string& key)>;
+
+    Reconciler(WorkQueue& queue, ReconcileFunc reconcile, size_t workerCount = std::thread::hardware_concurrency())
+        : queue(queue), reconcile(std::move(reconcile)) {
+        workerCount = std::max<size_t>(workerCount, 1);
+        for (size_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~Reconciler() {
+        queue.shutDown();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    Reconciler(const Reconciler&) = delete;
+    Reconciler& operator=(const Reconciler&) = delete;
+
+    uint64_t reconciled() const {
+        return reconcileCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    WorkQueue& queue;
+    ReconcileFunc reconcile;
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> reconcileCount{0};
+
+    void workerLoop() {
+        std::string key;
+        while (queue.get(key)) {
+            bool succeeded = false;
+            ApiMetrics::instance().clearLastFailure();
+            try {
+                succeeded = reconcile(key);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Reconcile of ", key, " threw: ", e.what());
+            }
+            reconcileCount.fetch_add(1, std::memory_order_relaxed);
+            if (succeeded) {
+                queue.forget(key);
+            } else {
+                LOG_WARN("Reconcile of ", key, " failed, retry ", queue.numRequeues(key) + 1);
+                ApiMetrics::instance().recordRetryOfLastFailure();
+                queue.addRateLimited(key);
+            }
+            queue.done(key);
+        }
+    }
+};
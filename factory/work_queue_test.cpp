@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "work_queue.h"
+#include "test_check.h"
+
+using Clock = std::chrono::steady_clock;
+
+int64_t millisSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+int main() {
+    // Adds of a key that is already queued collapse into one entry
+    {
+        WorkQueue queue;
+        for (int i = 0; i < 100; ++i) {
+            queue.add("default/a");
+            queue.add("default/b");
+        }
+        check(queue.length() == 2, "duplicate adds collapse while queued");
+    }
+
+    // A storm of updates while a key is being reconciled produces exactly one
+    // more reconcile, not one per update
+    {
+        WorkQueue queue;
+        std::promise<void> release;
+        std::shared_future<void> gate = release.get_future().share();
+        std::atomic<int> calls{0};
+        {
+            Reconciler reconciler(queue, [&](const std::string&) {
+                if (++calls == 1) {
+                    gate.wait();
+                }
+                return true;
+            }, 4);
+            queue.add("storm");
+            while (calls.load() == 0) {
+                std::this_thread::yield();
+            }
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&queue] {
+                    for (int i = 0; i < 1000; ++i) {
+                        queue.add("storm");
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            check(calls.load() == 1, "no second worker picks up a key that is being processed");
+            release.set_value();
+            auto start = Clock::now();
+            while (calls.load() < 2 && millisSince(start) < 2000) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        check(calls.load() == 2, "4000 updates during one reconcile fold into a single follow-up, got " +
+                                     std::to_string(calls.load()));
+    }
+
+    // Concurrent producers and workers never process one key on two workers at once
+    {
+        const int keyCount = 8;
+        std::vector<std::atomic<int>> active(keyCount);
+        std::atomic<int> overlaps{0};
+        std::atomic<int> reconciles{0};
+        WorkQueue queue;
+        {
+            Reconciler reconciler(queue, [&](const std::string& key) {
+                int index = std::stoi(key);
+                if (active[index].fetch_add(1) != 0) {
+                    ++overlaps;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+                active[index].fetch_sub(1);
+                ++reconciles;
+                return true;
+            }, 8);
+            std::vector<std::thread> producers;
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&queue, t] {
+                    for (int i = 0; i < 2000; ++i) {
+                        queue.add(std::to_string((i * 7 + t) % keyCount));
+                    }
+                });
+            }
+            for (auto& producer : producers) {
+                producer.join();
+            }
+            while (queue.length() > 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        check(overlaps.load() == 0, "a key was processed by two workers at once");
+        check(reconciles.load() > 0 && reconciles.load() < 8000, "adds collapse under concurrent producers");
+    }
+
+    // Failures back off exponentially, capped at maxDelay, drawn from [delay/2, delay]
+    {
+        const int base = 20;
+        const int cap = 80;
+        WorkQueue queue{std::chrono::milliseconds(base), std::chrono::milliseconds(cap)};
+        std::string key;
+        for (int attempt = 1; attempt <= 5; ++attempt) {
+            int expected = std::min(base << (attempt - 1), cap);
+            auto start = Clock::now();
+            queue.addRateLimited("flaky");
+            queue.get(key);
+            int64_t waited = millisSince(start);
+            queue.done(key);
+            check(waited >= expected / 2 - 1 && waited <= expected + 50,
+                  "attempt " + std::to_string(attempt) + " waited " + std::to_string(waited) + "ms, expected " +
+                      std::to_string(expected / 2) + "-" + std::to_string(expected) + "ms");
+        }
+        check(queue.numRequeues("flaky") == 5 && queue.retries() == 5, "requeues are counted");
+        queue.forget("flaky");
+        check(queue.numRequeues("flaky") == 0, "forget resets the backoff");
+
+        // Keys that fail together are spread out by the jitter
+        auto start = Clock::now();
+        const int keyCount = 20;
+        for (int i = 0; i < keyCount; ++i) {
+            queue.addRateLimited("jitter-" + std::to_string(i));
+        }
+        std::vector<int64_t> arrivals;
+        for (int i = 0; i < keyCount; ++i) {
+            queue.get(key);
+            arrivals.push_back(millisSince(start));
+            queue.done(key);
+        }
+        int64_t spread = *std::max_element(arrivals.begin(), arrivals.end()) -
+                         *std::min_element(arrivals.begin(), arrivals.end());
+        check(spread >= 2, "retries of keys that failed together are jittered, spread " + std::to_string(spread) + "ms");
+    }
+
+    // Failed reconciles are retried until they succeed
+    {
+        WorkQueue queue(std::chrono::milliseconds(1));
+        std::atomic<int> attempts{0};
+        {
+            Reconciler reconciler(queue, [&](const std::string&) {
+                return ++attempts >= 3;
+            }, 2);
+            queue.add("retry");
+            auto start = Clock::now();
+            while (attempts.load() < 3 && millisSince(start) < 2000) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        check(attempts.load() == 3, "key retried until reconcile succeeds, then forgotten");
+        check(queue.numRequeues("retry") == 0, "success clears the failure count");
+    }
+
+    return testResult();
+}
@@ -1,3 +1,11 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
 template <typename T, std::size_t MaxSize>
 class StaticStorage {
 private: